@@ -0,0 +1,403 @@
+#ifndef CSV_H
+#define CSV_H
+
+/*
+  DELIMITED TEXT (CSV) PARSER FOR APOLLO CODEBASE
+
+  % Parses a buffer in place (e.g. a view from fsi_mapFile), every field is a StrView into it
+    and the field array of a record comes from a MemSeg, no byte of the input is copied
+
+  % Separators, quotes and line ends of 64 bytes are found at once (see strview_split) and kept
+    in a bitmask, the parser then jumps from one to the next
+
+  % Records end in \n or \r\n, a quoted field ("a, ""b""") may hold separators and line ends,
+    it comes back without its outer quotes but with doubled quotes left as they are,
+    Csv_Record.escaped tells when csv_unquote is needed
+
+  % csv_parseParallel splits the buffer at record boundaries (quote parity is counted first so
+    a line end inside a quoted field is never taken for one) and parses every part on its own thread,
+    a quote that csv_next would read as a plain byte (e.g. 5" disk) breaks the parity count, the
+    buffer is then parsed as one part
+
+  % The translation unit also needs STRVIEW_IMPLEMENTATION and MEMSEG_IMPLEMENTATION
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "strview.h"
+#include "memseg.h"
+
+#ifdef APOLLO_DEF
+#undef APOLLO_DEF
+#endif
+#ifdef CSV_IMPLEMENTATION
+#define APOLLO_DEF static
+#else
+#define APOLLO_DEF
+#endif
+
+/* Quote character, a field starting with it is quoted */
+#ifndef CSV_QUOTE
+#define CSV_QUOTE '"'
+#endif
+
+/* Most parts csv_parseParallel splits a buffer into */
+#ifndef CSV_MAX_PARTS
+#define CSV_MAX_PARTS 64
+#endif
+
+/*
+  One record
+  @param fields: fields of the record, allocated from the parser's memseg
+  @param count: amount of fields
+  @param escaped: a quoted field of the record holds doubled quotes
+*/
+typedef struct {
+  StrView *fields;
+  size_t count;
+  bool escaped;
+} Csv_Record;
+
+/*
+  Struct describing a parser
+  @param src: buffer being parsed
+  @param memseg: memseg the field arrays are allocated from
+  @param pos: start of the next record
+  @param block: offset of the 64 byte block in mask
+  @param mask: separators / quotes / line ends of block at or after the parser's position
+  @param width: most fields seen in a record, size of the next field array
+  @param sep: field separator
+  @param failed: the memseg ran out, csv_next returns false from then on
+*/
+typedef struct {
+  StrView src;
+  MemSeg *memseg;
+  size_t pos;
+  size_t block;
+  uint64_t mask;
+  size_t width;
+  char sep;
+  bool failed;
+} Csv_Parser;
+
+/*
+  Called by csv_parseParallel for every record, from the thread parsing its part
+  @param record: the record, its field array is only valid during the call
+  @param part: index of the part (and memseg) the record belongs to
+  @param user: user pointer given to csv_parseParallel
+*/
+typedef void (*Csv_Callback)(Csv_Record *record, unsigned part, void *user);
+
+/*
+  Initialize a parser
+  @param parser: stack address of the parser
+  @param src: buffer to parse, must outlive every record
+  @param sep: field separator (e.g. ',' or '\t')
+  @param memseg: memseg the field arrays are allocated from
+*/
+APOLLO_DEF void csv_init(Csv_Parser *parser, StrView src, char sep, MemSeg *memseg);
+
+/*
+  Parses the next record, an empty line is a record with one empty field
+  @param parser: stack address of the parser
+  @param record: gets the record
+  @returns false at the end of the buffer or when the memseg is full (parser->failed)
+*/
+APOLLO_DEF bool csv_next(Csv_Parser *parser, Csv_Record *record);
+
+/*
+  Copies a quoted field with its doubled quotes collapsed
+  @param field: field of a record
+  @param buffer: destination, field.size bytes are always enough
+  @returns amount of bytes written
+*/
+APOLLO_DEF size_t csv_unquote(StrView field, char *buffer);
+
+/*
+  Parses a buffer on (parts) threads, part i allocates from memsegs[i] and is rewound after every record
+  @param src: buffer to parse
+  @param sep: field separator
+  @param parts: amount of parts / threads, at most CSV_MAX_PARTS
+  @param memsegs: one memseg per part
+  @param callback: called for every record
+  @param user: passed to callback
+  @returns amount of records parsed
+*/
+APOLLO_DEF size_t csv_parseParallel(StrView src, char sep, unsigned parts, MemSeg *memsegs, Csv_Callback callback, void *user);
+
+#endif
+
+/////////////////////////////////////////
+//           IMPLEMENTATION            //
+/////////////////////////////////////////
+
+#if defined(CSV_IMPLEMENTATION) && !defined(CSV_IMPLEMENTED)
+#define CSV_IMPLEMENTED
+
+#ifndef APOLLO_DEF
+#define APOLLO_DEF static
+#else
+#undef APOLLO_DEF
+#define APOLLO_DEF static
+#endif
+
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CSV_POPCOUNT(x) ((size_t)__popcnt64(x))
+#else
+#define CSV_POPCOUNT(x) ((size_t)__builtin_popcountll(x))
+#endif
+
+/* First field array of a parser, later ones are as wide as the widest record so far */
+#define CSV_MIN_WIDTH 8
+
+APOLLO_DEF void csv_init(Csv_Parser *parser, StrView src, char sep, MemSeg *memseg) {
+  memset(parser, 0, sizeof(Csv_Parser));
+  parser->src = src;
+  parser->memseg = memseg;
+  parser->sep = sep;
+  parser->width = CSV_MIN_WIDTH;
+
+  char set[3] = {sep, CSV_QUOTE, '\n'};
+  parser->mask = strview_blockMask(src, 0, set, 3);
+}
+
+/* INTERNAL!!!, next separator / quote / line end, src.size once there is none */
+APOLLO_DEF size_t csv_pop(Csv_Parser *parser) {
+  while (parser->mask == 0) {
+    parser->block += 64;
+    if (parser->block >= parser->src.size) return parser->src.size;
+    char set[3] = {parser->sep, CSV_QUOTE, '\n'};
+    parser->mask = strview_blockMask(parser->src, parser->block, set, 3);
+  }
+
+  size_t ret = parser->block + strview_ctz(parser->mask);
+  parser->mask &= parser->mask - 1;
+  return ret;
+}
+
+APOLLO_DEF bool csv_next(Csv_Parser *parser, Csv_Record *record) {
+  if (parser->failed || parser->pos >= parser->src.size) return false;
+
+  const char *data = parser->src.data;
+  size_t size = parser->src.size;
+  size_t capacity = parser->width, count = 0;
+  StrView *fields = memseg_pushArray(parser->memseg, StrView, capacity);
+  if (fields == NULL) {
+    parser->failed = true;
+    return false;
+  }
+
+  size_t start = parser->pos, quoteEnd = 0;
+  bool inQuotes = false, quoted = false;
+  record->escaped = false;
+  for (;;) {
+    size_t at = csv_pop(parser);
+    char c = at < size ? data[at] : '\n';
+
+    if (inQuotes) {
+      if (at == size) {
+        quoteEnd = size;
+      } else if (c != CSV_QUOTE) {
+        continue;
+      } else if (at + 1 < size && data[at + 1] == CSV_QUOTE) {
+        csv_pop(parser);
+        record->escaped = true;
+        continue;
+      } else {
+        inQuotes = false;
+        quoteEnd = at;
+        continue;
+      }
+    } else if (c == CSV_QUOTE) {
+      // only a quote opening the field starts a quoted field, any other one is a plain byte
+      if (at == start && !quoted) inQuotes = quoted = true;
+      continue;
+    }
+
+    if (count == capacity) {
+      StrView *grown = memseg_pushArray(parser->memseg, StrView, capacity * 2);
+      if (grown == NULL) {
+        parser->failed = true;
+        return false;
+      }
+      memcpy(grown, fields, sizeof(StrView) * count);
+      fields = grown;
+      capacity *= 2;
+    }
+
+    StrView *field = &fields[count++];
+    if (quoted) {
+      *field = (StrView){.data=data + start + 1, .size=quoteEnd - start - 1};
+    } else {
+      size_t end = at;
+      if (at < size && c == '\n' && end > start && data[end - 1] == '\r') end--;
+      *field = (StrView){.data=data + start, .size=end - start};
+    }
+
+    start = at + 1;
+    quoted = false;
+    if (c != parser->sep || at == size) break;
+  }
+
+  parser->pos = start;
+  if (count > parser->width) parser->width = count;
+  record->fields = fields;
+  record->count = count;
+  return true;
+}
+
+APOLLO_DEF size_t csv_unquote(StrView field, char *buffer) {
+  size_t n = 0;
+  for (size_t i=0; i<field.size; i++) {
+    buffer[n++] = field.data[i];
+    if (field.data[i] == CSV_QUOTE && i + 1 < field.size && field.data[i + 1] == CSV_QUOTE) i++;
+  }
+  return n;
+}
+
+/*
+  INTERNAL!!!, one part of csv_parseParallel
+  the first pass only counts the quotes of [begin, end) and checks that each one opens or closes a
+  quoted field as csv_next would read it, for both quote parities the part may start with, the
+  second parses it
+*/
+typedef struct {
+  StrView src;
+  size_t begin;
+  size_t end;
+  size_t quotes;
+  bool stray[2];
+  size_t records;
+  MemSeg *memseg;
+  Csv_Callback callback;
+  void *user;
+  unsigned part;
+  char sep;
+  bool parse;
+} Csv_Part;
+
+#if defined(_WIN32)
+#define CSV_THREAD_RET DWORD WINAPI
+#else
+#define CSV_THREAD_RET void*
+#endif
+
+APOLLO_DEF CSV_THREAD_RET csv_partRun(void *data) {
+  Csv_Part *part = (Csv_Part*)data;
+  StrView range = strview_fromParts((char*)part->src.data + part->begin, part->end - part->begin);
+  if (!part->parse) {
+    const char quote = CSV_QUOTE;
+    const char *data = part->src.data;
+    size_t size = part->src.size;
+    for (size_t at = 0; at < range.size; at += 64) {
+      uint64_t mask = strview_blockMask(range, at, &quote, 1);
+      for (; mask != 0; mask &= mask - 1) {
+        // an opening quote starts a field (or follows a closing one, "" inside quotes), a closing
+        // quote ends the field (or is followed by the next one)
+        size_t pos = part->begin + at + strview_ctz(mask);
+        char before = pos > 0 ? data[pos - 1] : '\n', after = pos + 1 < size ? data[pos + 1] : '\n';
+        bool opens = before == part->sep || before == '\n' || before == CSV_QUOTE;
+        bool closes = after == part->sep || after == '\n' || after == '\r' || after == CSV_QUOTE;
+        bool open = (part->quotes++ & 1) == 0;
+        if (!opens) part->stray[!open] = true;
+        if (!closes) part->stray[open] = true;
+      }
+    }
+    return 0;
+  }
+
+  Csv_Parser parser;
+  Csv_Record record;
+  csv_init(&parser, range, part->sep, part->memseg);
+  MemSeg_Mark mark = memseg_mark(part->memseg);
+  while (csv_next(&parser, &record)) {
+    part->callback(&record, part->part, part->user);
+    memseg_rewind(part->memseg, mark);
+    part->records++;
+  }
+  return 0;
+}
+
+/* INTERNAL!!!, runs csv_partRun on every part, on threads where possible */
+APOLLO_DEF void csv_partsRun(Csv_Part *parts, unsigned count) {
+#if defined(_WIN32)
+  HANDLE threads[CSV_MAX_PARTS];
+  for (unsigned i=1; i<count; i++) threads[i] = CreateThread(NULL, 0, csv_partRun, &parts[i], 0, NULL);
+  csv_partRun(&parts[0]);
+  for (unsigned i=1; i<count; i++) {
+    if (threads[i] == NULL) {
+      csv_partRun(&parts[i]);
+      continue;
+    }
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+  }
+#else
+  pthread_t threads[CSV_MAX_PARTS];
+  bool started[CSV_MAX_PARTS];
+  for (unsigned i=1; i<count; i++) started[i] = pthread_create(&threads[i], NULL, csv_partRun, &parts[i]) == 0;
+  csv_partRun(&parts[0]);
+  for (unsigned i=1; i<count; i++) {
+    if (started[i]) pthread_join(threads[i], NULL);
+    else csv_partRun(&parts[i]);
+  }
+#endif
+}
+
+APOLLO_DEF size_t csv_parseParallel(StrView src, char sep, unsigned parts, MemSeg *memsegs, Csv_Callback callback, void *user) {
+  if (parts == 0) parts = 1;
+  if (parts > CSV_MAX_PARTS) parts = CSV_MAX_PARTS;
+
+  Csv_Part part[CSV_MAX_PARTS];
+  for (unsigned i=0; i<parts; i++) {
+    part[i] = (Csv_Part){.src=src, .begin=src.size / parts * i, .end=src.size / parts * (i + 1),
+      .memseg=&memsegs[i], .callback=callback, .user=user, .part=i, .sep=sep};
+  }
+  part[parts - 1].end = src.size;
+  csv_partsRun(part, parts);
+
+  size_t parity = 0;
+  for (unsigned i=0; i<parts; i++) {
+    if (part[i].stray[parity & 1]) {
+      part[0].end = src.size;
+      parts = 1;
+      break;
+    }
+    parity += part[i].quotes;
+  }
+
+  // a part starts after the first line end at or past its cut that is outside quotes
+  size_t quotes = 0;
+  for (unsigned i=1; i<parts; i++) {
+    quotes += part[i - 1].quotes;
+    size_t at = part[i].begin;
+    bool inQuotes = quotes & 1;
+    for (; at < src.size; at++) {
+      if (src.data[at] == CSV_QUOTE) inQuotes = !inQuotes;
+      else if (src.data[at] == '\n' && !inQuotes) break;
+    }
+    size_t begin = at < src.size ? at + 1 : src.size;
+    part[i].begin = begin > part[i - 1].begin ? begin : part[i - 1].begin;
+    part[i - 1].end = part[i].begin;
+  }
+
+  for (unsigned i=0; i<parts; i++) part[i].parse = true;
+  csv_partsRun(part, parts);
+
+  size_t records = 0;
+  for (unsigned i=0; i<parts; i++) records += part[i].records;
+  return records;
+}
+
+#endif
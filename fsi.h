@@ -1,31 +1,48 @@
 #ifndef FSI_H
 #define FSI_H
 
-#ifndef APOLLO_DEF
-#define APOLLO_DEF
-#else
-#undef APOLLO_DEF
-#define APOLLO_DEF
-#endif
-
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <stdio.h>
 
+#include "strview.h"
+
+#ifdef APOLLO_DEF
+#undef APOLLO_DEF
+#endif
+#ifdef FSI_IMPLEMENTATION
+#define APOLLO_DEF static
+#else
+#define APOLLO_DEF
+#endif
+
 /*
   Struct abstracting files, when not using stdio _iobuf automatically closes files
   @param filePath: file path as char*
   @param fileHandle: file handle as _iobuf (stdio.h)
-  @param tag: set to 1 if using _iobuf (FILE*)
+  @param fileDesc: open descriptor (HANDLE on windows), positional reads / writes without reopening
+  @param tag: set to 1 if using _iobuf (FILE*), 2 if using a descriptor (fsi_FileOpen)
 */
 typedef struct {
   union {
     char *filePath;
     FILE *fileHandle;
+    intptr_t fileDesc;
   };
   uint8_t tag;
 } fsi_File;
 
+/*
+  Modes for fsi_FileOpen
+  @param FSI_OPEN_READ: read only, the file must exist
+  @param FSI_OPEN_WRITE: read and write, the file is created if missing
+  @param FSI_OPEN_APPEND: write only, the file is created if missing and every write lands at its end
+*/
+#define FSI_OPEN_READ 0
+#define FSI_OPEN_WRITE 1
+#define FSI_OPEN_APPEND 2
+
 /*
   Struct containign begin and end offsets for file operations
   @param begin: beginning of operation
@@ -38,6 +55,18 @@ typedef struct {
 
 #define fsi_Offset(_begin, _end) ((fsi_Offset){.begin=_begin, .end=_end})
 
+/*
+  Access hints for mapped files, can be or'd together
+  @param FSI_ACCESS_NORMAL: no hint, the OS default read-ahead
+  @param FSI_ACCESS_SEQUENTIAL: pages are read in order, read ahead aggressively and drop them behind
+  @param FSI_ACCESS_RANDOM: pages are read in no order, do not read ahead
+  @param FSI_ACCESS_WILLNEED: the range is needed soon, start reading it in now
+*/
+#define FSI_ACCESS_NORMAL 0
+#define FSI_ACCESS_SEQUENTIAL 1
+#define FSI_ACCESS_RANDOM 2
+#define FSI_ACCESS_WILLNEED 4
+
 /*
   Creates a fsi_File abstraction from a string path
   @param path: path to file
@@ -52,6 +81,22 @@ APOLLO_DEF fsi_File fsi_FileFromCstr(char *path);
 */
 APOLLO_DEF fsi_File fsi_FileFromStdIO(FILE *iobuf);
 
+/*
+  Opens a file once and keeps its descriptor, every operation on it is a single
+  fstat / pread / pwrite with no path lookup or stdio buffering
+  @param path: path to file
+  @param mode: FSI_OPEN_READ, FSI_OPEN_WRITE or FSI_OPEN_APPEND
+  @param file: gets the opened fsi_File
+  @returns true on success, false if the file could not be opened
+*/
+APOLLO_DEF bool fsi_FileOpen(char *path, uint8_t mode, fsi_File *file);
+
+/*
+  Closes a file opened by fsi_FileOpen, does nothing for other files
+  @param file: file from fsi_FileOpen
+*/
+APOLLO_DEF void fsi_FileClose(fsi_File file);
+
 /*
   Gets size of specified file
   @param file: handle containing path to file
@@ -63,7 +108,7 @@ APOLLO_DEF size_t fsi_getFileSize(fsi_File file);
   Read all contents from a file
   @param file: handle containing path to file
   @param bytesRead: gets modified with the value of readed bytes, unless NULL
-  @return a malloc'd memory block containing file contents
+  @return a malloc'd memory block containing file contents, NULL if the path can't be opened
 */
 APOLLO_DEF char *fsi_readFile(fsi_File file, size_t *bytesRead);
 
@@ -85,6 +130,293 @@ APOLLO_DEF size_t fsi_writeFile(fsi_File file, void *content, size_t n);
 */
 APOLLO_DEF char *fsi_readFileEx(fsi_File file, fsi_Offset offset, size_t *bytesRead);
 
+/*
+  Read contents from a file into a caller buffer, no allocation
+  @param file: handle containing path to file
+  @param offset: offset specifying range of read operation
+  @param buffer: receives the contents, at least offset.end - offset.begin bytes
+  @return number of bytes read, less than asked at the end of the file, 0 if the path can't be opened
+*/
+APOLLO_DEF size_t fsi_readInto(fsi_File file, fsi_Offset offset, void *buffer);
+
+/*
+  Writes contents to file at a position, the rest of the file is kept
+  @param file: handle containing path to file
+  @param position: offset of the first byte written
+  @param content: pointer to content
+  @param n: sizeof content
+  @return number of bytes written
+*/
+APOLLO_DEF size_t fsi_writeFileEx(fsi_File file, size_t position, void *content, size_t n);
+
+/*
+  Maps a whole file read-only into memory, no copy is made, pages are read in on first touch
+  @param file: any fsi_File, a FILE* or descriptor stays open and usable
+  @param access: FSI_ACCESS_* hints for the whole mapping
+  @return a view of the file contents (not NUL terminated), data is NULL on error,
+          an empty file gives an empty view, release it with fsi_unmapFile
+*/
+APOLLO_DEF StrView fsi_mapFile(fsi_File file, uint8_t access);
+
+/*
+  Changes the access hints for a range of a mapped file, eg. FSI_ACCESS_WILLNEED ahead of a scan
+  @param map: view returned by fsi_mapFile
+  @param offset: range of the view the hints apply to
+  @param access: FSI_ACCESS_* hints
+*/
+APOLLO_DEF void fsi_adviseMap(StrView map, fsi_Offset offset, uint8_t access);
+
+/*
+  Releases a view returned by fsi_mapFile, every StrView into it becomes invalid
+  @param map: view returned by fsi_mapFile
+*/
+APOLLO_DEF void fsi_unmapFile(StrView map);
+
+/*
+  Streaming reader over a file through one fixed size buffer, the next range is hinted to the OS
+  (posix_fadvise WILLNEED) as soon as one is read so the disk works ahead of the caller
+  @param file: file being read, a path is opened once for the whole stream
+  @param buffer: holds the chunks, split in two halves in chunk mode
+  @param capacity: size of buffer in bytes
+  @param begin: first unconsumed byte of buffer in record mode
+  @param end: one past the last byte read into buffer
+  @param half: half of buffer the next chunk is read into
+  @param position: file offset of the next read
+  @param ownsBuffer: buffer was malloc'd by fsi_readerInit
+  @param ownsFile: file was opened by fsi_readerInit
+  @param eof: nothing is left to read from file
+*/
+typedef struct {
+  fsi_File file;
+  char *buffer;
+  size_t capacity;
+  size_t begin;
+  size_t end;
+  size_t half;
+  size_t position;
+  bool ownsBuffer;
+  bool ownsFile;
+  bool eof;
+} fsi_Reader;
+
+/*
+  Starts a streaming read of a file
+  @param reader: reader to set up
+  @param file: any fsi_File, read from its start (a FILE* from its current position)
+  @param buffer: caller memory (eg. from memseg_alloc) used for the chunks, malloc'd when NULL
+  @param capacity: size of buffer, also the longest record fsi_readerRecord returns whole
+  @returns false if the file could not be opened or the buffer allocated
+*/
+APOLLO_DEF bool fsi_readerInit(fsi_Reader *reader, fsi_File file, void *buffer, size_t capacity);
+
+/*
+  Releases what fsi_readerInit allocated or opened, a caller buffer is left alone
+  @param reader: reader from fsi_readerInit
+*/
+APOLLO_DEF void fsi_readerFree(fsi_Reader *reader);
+
+/*
+  Reads the next chunk of up to capacity / 2 bytes, chunks alternate between the two halves
+  of the buffer so a chunk stays valid until the call after the next one
+  @param reader: reader from fsi_readerInit
+  @return view of the chunk, empty at end of file
+*/
+APOLLO_DEF StrView fsi_readerNext(fsi_Reader *reader);
+
+/*
+  Reads the next record ending in (delim) (not part of the view), a record cut by the end of the
+  buffer is moved to its front and completed, only that partial record is ever copied
+  @param reader: reader from fsi_readerInit, not to be mixed with fsi_readerNext
+  @param delim: record separator, eg. '\n'
+  @param record: view of the record, valid until the next call, a record longer than the buffer
+                 comes back in buffer sized pieces, the last one may lack its delimiter
+  @return false once every record was returned
+*/
+APOLLO_DEF bool fsi_readerRecord(fsi_Reader *reader, char delim, StrView *record);
+
+/*
+  Operations and backends of the asynchronous I/O engine
+  @param FSI_IO_READ / FSI_IO_WRITE: operation of a fsi_IORequest
+  @param FSI_IO_AUTO: io_uring when the kernel allows it, else the thread pool
+  @param FSI_IO_URING: linux io_uring, one syscall submits a whole batch
+  @param FSI_IO_THREADS: FSI_IO_THREAD_COUNT threads doing pread / pwrite
+  @param FSI_IO_SYNC: requests run one after another inside fsi_ioSubmit (windows)
+*/
+#define FSI_IO_READ 0
+#define FSI_IO_WRITE 1
+
+#define FSI_IO_AUTO 0
+#define FSI_IO_URING 1
+#define FSI_IO_THREADS 2
+#define FSI_IO_SYNC 3
+
+#ifndef FSI_IO_THREAD_COUNT
+#define FSI_IO_THREAD_COUNT 4
+#endif
+
+/*
+  One read / write of the asynchronous engine, owned by the caller until it completes
+  @param file: descriptor (fsi_FileOpen) or FILE* the request works on
+  @param buffer: destination of a read, source of a write
+  @param size: bytes to transfer, at most UINT32_MAX (the most one io_uring request can take)
+  @param offset: file offset of the first byte
+  @param op: FSI_IO_READ or FSI_IO_WRITE
+  @param result: set on completion, bytes transferred (may be short at end of file) or -errno
+  @param user: free for the caller
+*/
+typedef struct {
+  fsi_File file;
+  void *buffer;
+  size_t size;
+  size_t offset;
+  uint8_t op;
+  intptr_t result;
+  void *user;
+} fsi_IORequest;
+
+/*
+  Asynchronous I/O engine, queue requests, submit them as one batch, then reap completions
+  @param depth: most requests queued or in flight at once
+  @param queued: requests queued since the last submit
+  @param inFlight: requests submitted and not reaped yet
+  @param backend: FSI_IO_URING, FSI_IO_THREADS or FSI_IO_SYNC, whichever is in use
+  @param state: backend internals
+*/
+typedef struct {
+  unsigned depth;
+  unsigned queued;
+  unsigned inFlight;
+  uint8_t backend;
+  void *state;
+} fsi_IO;
+
+/*
+  Sets up an I/O engine
+  @param io: engine to set up
+  @param depth: most requests queued or in flight at once
+  @param backend: FSI_IO_AUTO, or a backend to force
+  @returns false if the backend could not be started
+*/
+APOLLO_DEF bool fsi_ioInit(fsi_IO *io, unsigned depth, uint8_t backend);
+
+/*
+  Waits for every request in flight and releases the engine
+  @param io: engine from fsi_ioInit
+*/
+APOLLO_DEF void fsi_ioFree(fsi_IO *io);
+
+/*
+  Queues a request for the next fsi_ioSubmit, nothing is done yet
+  @param io: engine from fsi_ioInit
+  @param request: request to queue, must stay valid until it is returned by fsi_ioComplete
+  @returns false if depth requests are already queued or in flight, the file is a path,
+           or size is over UINT32_MAX
+*/
+APOLLO_DEF bool fsi_ioQueue(fsi_IO *io, fsi_IORequest *request);
+
+/*
+  Submits every queued request as one batch
+  @param io: engine from fsi_ioInit
+  @returns number of requests submitted, when the kernel takes fewer (io_uring busy) the rest stay
+           queued for the next fsi_ioSubmit
+*/
+APOLLO_DEF unsigned fsi_ioSubmit(fsi_IO *io);
+
+/*
+  Reaps completed requests, in completion order
+  @param io: engine from fsi_ioInit
+  @param done: receives up to (max) completed requests
+  @param max: size of done
+  @param wait: block until at least one request completes (if any is in flight)
+  @returns number of requests stored into done
+*/
+APOLLO_DEF unsigned fsi_ioComplete(fsi_IO *io, fsi_IORequest **done, unsigned max, bool wait);
+
+/*
+  Durability of a fsi_Writer, when written data is forced to the disk (fdatasync)
+  @param FSI_SYNC_NONE: only on fsi_writerCommit, the OS flushes whenever it likes
+  @param FSI_SYNC_PERIODIC: on a flush at least (interval) milliseconds after the last sync
+  @param FSI_SYNC_GROUP: once every (interval) records, they all share one sync
+*/
+#define FSI_SYNC_NONE 0
+#define FSI_SYNC_PERIODIC 1
+#define FSI_SYNC_GROUP 2
+
+/*
+  Buffered append-only writer, records are gathered in one buffer and written with a single
+  writev once it is full, so many small appends cost one syscall
+  @param file: file being appended to
+  @param desc: descriptor / handle of file every write goes through
+  @param buffer: holds records not written yet
+  @param capacity: size of buffer in bytes
+  @param used: bytes of buffer holding records
+  @param records: records appended since the last sync
+  @param lastSync: time of the last sync in milliseconds
+  @param interval: milliseconds (FSI_SYNC_PERIODIC) or records (FSI_SYNC_GROUP) between syncs
+  @param sync: FSI_SYNC_NONE, FSI_SYNC_PERIODIC or FSI_SYNC_GROUP
+  @param ownsBuffer: buffer was malloc'd by fsi_writerInit
+  @param ownsFile: file was opened by fsi_writerInit
+  @param failed: a write or sync failed, the writer refuses anything more
+*/
+typedef struct {
+  fsi_File file;
+  intptr_t desc;
+  char *buffer;
+  size_t capacity;
+  size_t used;
+  size_t records;
+  uint64_t lastSync;
+  uint32_t interval;
+  uint8_t sync;
+  bool ownsBuffer;
+  bool ownsFile;
+  bool failed;
+} fsi_Writer;
+
+/*
+  Starts appending to a file, the existing content is kept
+  @param writer: writer to set up
+  @param file: a path (opened with FSI_OPEN_APPEND), a descriptor or a FILE*, written from its end
+  @param buffer: caller memory (eg. from memseg_alloc) for pending records, malloc'd when NULL
+  @param capacity: size of buffer
+  @param sync: FSI_SYNC_NONE, FSI_SYNC_PERIODIC or FSI_SYNC_GROUP
+  @param interval: milliseconds or records between syncs, see FSI_SYNC_*
+  @returns false if the file could not be opened or the buffer allocated
+*/
+APOLLO_DEF bool fsi_writerInit(fsi_Writer *writer, fsi_File file, void *buffer, size_t capacity, uint8_t sync, uint32_t interval);
+
+/*
+  Appends a record, it is only copied if it fits in the buffer, otherwise the buffer and
+  the record go out together in one writev
+  @param writer: writer from fsi_writerInit
+  @param data: bytes to append
+  @param n: number of bytes
+  @returns false if the write or a sync it triggered failed
+*/
+APOLLO_DEF bool fsi_writerAppend(fsi_Writer *writer, const void *data, size_t n);
+
+/*
+  Writes out the buffered records, without forcing them to the disk
+  @param writer: writer from fsi_writerInit
+  @returns false if the write failed
+*/
+APOLLO_DEF bool fsi_writerFlush(fsi_Writer *writer);
+
+/*
+  Writes out the buffered records and waits until everything appended so far is on the disk
+  @param writer: writer from fsi_writerInit
+  @returns false if the write or the sync failed
+*/
+APOLLO_DEF bool fsi_writerCommit(fsi_Writer *writer);
+
+/*
+  Flushes (and commits unless FSI_SYNC_NONE) the writer then releases what fsi_writerInit
+  allocated or opened
+  @param writer: writer from fsi_writerInit
+  @returns false if the last records could not be written
+*/
+APOLLO_DEF bool fsi_writerFree(fsi_Writer *writer);
+
 #endif
 
 #ifdef FSI_IMPLEMENTATION
@@ -98,6 +430,27 @@ APOLLO_DEF char *fsi_readFileEx(fsi_File file, fsi_Offset offset, size_t *bytesR
 
 #include <stdlib.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <time.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+#include <string.h>
+
 APOLLO_DEF inline fsi_File fsi_FileFromCstr(char *path) {
   return (fsi_File){.filePath=path, .tag=0};
 }
@@ -106,9 +459,107 @@ APOLLO_DEF inline fsi_File fsi_FileFromStdIO(FILE *iobuf) {
   return (fsi_File){.fileHandle=iobuf, .tag=1};
 }
 
+/* Positional I/O on descriptors, loops over short reads / writes, stops at end of file or error */
+#if defined(_WIN32)
+APOLLO_DEF size_t fsi_descSize(intptr_t desc) {
+  LARGE_INTEGER size;
+  return GetFileSizeEx((HANDLE)desc, &size) ? (size_t)size.QuadPart : 0;
+}
+
+APOLLO_DEF size_t fsi_descRead(intptr_t desc, void *buffer, size_t n, size_t position) {
+  size_t done = 0;
+  while (done < n) {
+    OVERLAPPED at = {0};
+    at.Offset = (DWORD)(position + done);
+    at.OffsetHigh = (DWORD)((uint64_t)(position + done) >> 32);
+    DWORD chunk = n - done > 0x40000000 ? 0x40000000 : (DWORD)(n - done), got = 0;
+    if (!ReadFile((HANDLE)desc, (char*)buffer + done, chunk, &got, &at) || got == 0) break;
+    done += got;
+  }
+  return done;
+}
+
+APOLLO_DEF size_t fsi_descWrite(intptr_t desc, const void *content, size_t n, size_t position) {
+  size_t done = 0;
+  while (done < n) {
+    OVERLAPPED at = {0};
+    at.Offset = (DWORD)(position + done);
+    at.OffsetHigh = (DWORD)((uint64_t)(position + done) >> 32);
+    DWORD chunk = n - done > 0x40000000 ? 0x40000000 : (DWORD)(n - done), put = 0;
+    if (!WriteFile((HANDLE)desc, (const char*)content + done, chunk, &put, &at) || put == 0) break;
+    done += put;
+  }
+  return done;
+}
+
+APOLLO_DEF void fsi_descTruncate(intptr_t desc, size_t size) {
+  FILE_END_OF_FILE_INFO end;
+  end.EndOfFile.QuadPart = (LONGLONG)size;
+  SetFileInformationByHandle((HANDLE)desc, FileEndOfFileInfo, &end, sizeof(end));
+}
+#else
+APOLLO_DEF size_t fsi_descSize(intptr_t desc) {
+  struct stat st;
+  return fstat((int)desc, &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+APOLLO_DEF size_t fsi_descRead(intptr_t desc, void *buffer, size_t n, size_t position) {
+  size_t done = 0;
+  while (done < n) {
+    ssize_t got = pread((int)desc, (char*)buffer + done, n - done, (off_t)(position + done));
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) break;
+    done += (size_t)got;
+  }
+  return done;
+}
+
+APOLLO_DEF size_t fsi_descWrite(intptr_t desc, const void *content, size_t n, size_t position) {
+  size_t done = 0;
+  while (done < n) {
+    ssize_t put = pwrite((int)desc, (const char*)content + done, n - done, (off_t)(position + done));
+    if (put < 0 && errno == EINTR) continue;
+    if (put <= 0) break;
+    done += (size_t)put;
+  }
+  return done;
+}
+
+APOLLO_DEF void fsi_descTruncate(intptr_t desc, size_t size) {
+  (void)!ftruncate((int)desc, (off_t)size);
+}
+#endif
+
+APOLLO_DEF bool fsi_FileOpen(char *path, uint8_t mode, fsi_File *file) {
+#if defined(_WIN32)
+  DWORD access = mode == FSI_OPEN_APPEND ? FILE_APPEND_DATA : mode == FSI_OPEN_WRITE ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+  HANDLE handle = CreateFileA(path, access, FILE_SHARE_READ, NULL,
+    mode == FSI_OPEN_READ ? OPEN_EXISTING : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (handle == INVALID_HANDLE_VALUE) return false;
+  *file = (fsi_File){.fileDesc=(intptr_t)handle, .tag=2};
+#else
+  int fd = mode == FSI_OPEN_APPEND ? open(path, O_WRONLY | O_CREAT | O_APPEND, 0644)
+    : mode == FSI_OPEN_WRITE ? open(path, O_RDWR | O_CREAT, 0644) : open(path, O_RDONLY);
+  if (fd < 0) return false;
+  *file = (fsi_File){.fileDesc=fd, .tag=2};
+#endif
+  return true;
+}
+
+APOLLO_DEF void fsi_FileClose(fsi_File file) {
+  if (file.tag != 2) return;
+#if defined(_WIN32)
+  CloseHandle((HANDLE)file.fileDesc);
+#else
+  close((int)file.fileDesc);
+#endif
+}
+
 APOLLO_DEF size_t fsi_getFileSize(fsi_File file) {
   size_t ret = 0;
-  if (!(file.tag)) {
+  if (file.tag == 2) {
+    ret = fsi_descSize(file.fileDesc);
+  } else if (!(file.tag)) {
     FILE *tmp = fopen(file.filePath, "r");
     fseek(tmp, 0, SEEK_END);
     ret = ftell(tmp);
@@ -124,15 +575,29 @@ APOLLO_DEF size_t fsi_getFileSize(fsi_File file) {
 }
 
 APOLLO_DEF char *fsi_readFile(fsi_File file, size_t *bytesRead) {
-  size_t size = fsi_getFileSize(file);
-  char *ret = (char*)malloc(size+1);
+  size_t size = 0;
   size_t read = 0;
+  char *ret = NULL;
 
-  if (!(file.tag)) {
+  if (file.tag == 2) {
+    size = fsi_descSize(file.fileDesc);
+    ret = (char*)malloc(size+1);
+    read = fsi_descRead(file.fileDesc, ret, size, 0);
+  } else if (!(file.tag)) {
     FILE* tmp = fopen(file.filePath, "rb");
+    if (tmp == NULL) {
+      if (bytesRead != NULL) *bytesRead = 0;
+      return NULL;
+    }
+    fseek(tmp, 0, SEEK_END);
+    size = ftell(tmp);
+    fseek(tmp, 0, SEEK_SET);
+    ret = (char*)malloc(size+1);
     read = fread(ret, 1, size, tmp);
     fclose(tmp);
   } else {
+    size = fsi_getFileSize(file);
+    ret = (char*)malloc(size+1);
     read = fread(ret, 1, size, file.fileHandle);
   }
 
@@ -144,7 +609,10 @@ APOLLO_DEF char *fsi_readFile(fsi_File file, size_t *bytesRead) {
 APOLLO_DEF size_t fsi_writeFile(fsi_File file, void *content, size_t n) {
   size_t ret = 0;
 
-  if (!(file.tag)) {
+  if (file.tag == 2) {
+    fsi_descTruncate(file.fileDesc, 0);
+    ret = fsi_descWrite(file.fileDesc, content, n, 0);
+  } else if (!(file.tag)) {
     FILE* tmp = fopen(file.filePath, "wb");
     ret = fwrite(content, 1, n, tmp);
     fclose(tmp);
@@ -155,26 +623,714 @@ APOLLO_DEF size_t fsi_writeFile(fsi_File file, void *content, size_t n) {
   return ret;
 }
 
-APOLLO_DEF char *fsi_readFileEx(fsi_File file, fsi_Offset offset, size_t *bytesRead) {
+APOLLO_DEF size_t fsi_writeFileEx(fsi_File file, size_t position, void *content, size_t n) {
+  size_t ret = 0;
+
+  if (file.tag == 2) {
+    ret = fsi_descWrite(file.fileDesc, content, n, position);
+  } else if (!(file.tag)) {
+    FILE* tmp = fopen(file.filePath, "r+b");
+    if (tmp == NULL) tmp = fopen(file.filePath, "w+b");
+    fseek(tmp, position, SEEK_SET);
+    ret = fwrite(content, 1, n, tmp);
+    fclose(tmp);
+  } else {
+    fseek(file.fileHandle, position, SEEK_SET);
+    ret = fwrite(content, 1, n, file.fileHandle);
+    fseek(file.fileHandle, 0, SEEK_SET);
+  }
+
+  return ret;
+}
+
+APOLLO_DEF size_t fsi_readInto(fsi_File file, fsi_Offset offset, void *buffer) {
   size_t size = offset.end - offset.begin;
   size_t read = 0;
-  char *ret = (char*)malloc(size+1);
 
-  if (!(file.tag)) {
+  if (file.tag == 2) {
+    read = fsi_descRead(file.fileDesc, buffer, size, offset.begin);
+  } else if (!(file.tag)) {
     FILE* tmp = fopen(file.filePath, "rb");
+    if (tmp == NULL) return 0;
     fseek(tmp, offset.begin, SEEK_SET);
-    read = fread(ret, 1, size, tmp);
-    fseek(tmp, 0, SEEK_SET);
+    read = fread(buffer, 1, size, tmp);
     fclose(tmp);
   } else {
     fseek(file.fileHandle, offset.begin, SEEK_SET);
-    read = fread(ret, 1, size, file.fileHandle);
+    read = fread(buffer, 1, size, file.fileHandle);
     fseek(file.fileHandle, 0, SEEK_SET);
   }
 
+  return read;
+}
+
+APOLLO_DEF char *fsi_readFileEx(fsi_File file, fsi_Offset offset, size_t *bytesRead) {
+  size_t size = offset.end - offset.begin;
+  char *ret = (char*)malloc(size+1);
+  size_t read = fsi_readInto(file, offset, ret);
+
   if (bytesRead != NULL) *bytesRead = read;
   ret[size] = '\0'; 
   return ret;
 }
 
+#if defined(_WIN32)
+APOLLO_DEF StrView fsi_mapFile(fsi_File file, uint8_t access) {
+  StrView ret = {0};
+  HANDLE handle;
+  if (!(file.tag)) {
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (access & FSI_ACCESS_SEQUENTIAL) flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    if (access & FSI_ACCESS_RANDOM) flags |= FILE_FLAG_RANDOM_ACCESS;
+    handle = CreateFileA(file.filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+  } else if (file.tag == 2) {
+    handle = (HANDLE)file.fileDesc;
+  } else {
+    handle = (HANDLE)_get_osfhandle(_fileno(file.fileHandle));
+  }
+  if (handle == INVALID_HANDLE_VALUE) return ret;
+
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(handle, &size)) {
+    if (size.QuadPart == 0) {
+      ret.data = "";
+    } else {
+      HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (mapping != NULL) {
+        ret.data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (ret.data != NULL) ret.size = (size_t)size.QuadPart;
+        CloseHandle(mapping);
+      }
+    }
+  }
+
+  if (!(file.tag)) CloseHandle(handle);
+  return ret;
+}
+
+/* windows only takes the hints as open flags, see fsi_mapFile */
+APOLLO_DEF void fsi_adviseMap(StrView map, fsi_Offset offset, uint8_t access) {
+  (void)map; (void)offset; (void)access;
+}
+
+APOLLO_DEF void fsi_unmapFile(StrView map) {
+  if (map.size != 0) UnmapViewOfFile(map.data);
+}
+#else
+APOLLO_DEF void fsi_adviseMap(StrView map, fsi_Offset offset, uint8_t access) {
+  if (map.size == 0 || offset.begin >= offset.end) return;
+  if (offset.end > map.size) offset.end = map.size;
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t begin = offset.begin & ~(page - 1);
+  char *base = (char*)map.data + begin;
+  size_t length = offset.end - begin;
+
+  if (access & FSI_ACCESS_SEQUENTIAL) madvise(base, length, MADV_SEQUENTIAL);
+  else if (access & FSI_ACCESS_RANDOM) madvise(base, length, MADV_RANDOM);
+  else madvise(base, length, MADV_NORMAL);
+  if (access & FSI_ACCESS_WILLNEED) madvise(base, length, MADV_WILLNEED);
+}
+
+APOLLO_DEF StrView fsi_mapFile(fsi_File file, uint8_t access) {
+  StrView ret = {0};
+  int fd = file.tag == 2 ? (int)file.fileDesc : !(file.tag) ? open(file.filePath, O_RDONLY) : fileno(file.fileHandle);
+  if (fd < 0) return ret;
+
+  struct stat st;
+  if (fstat(fd, &st) == 0) {
+    if (st.st_size == 0) {
+      ret.data = "";
+    } else {
+      void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        ret.data = (const char*)data;
+        ret.size = (size_t)st.st_size;
+        if (access != FSI_ACCESS_NORMAL) fsi_adviseMap(ret, fsi_Offset(0, ret.size), access);
+      }
+    }
+  }
+
+  if (!(file.tag)) close(fd);
+  return ret;
+}
+
+APOLLO_DEF void fsi_unmapFile(StrView map) {
+  if (map.size != 0) munmap((void*)map.data, map.size);
+}
+#endif
+
+/* Reads into the buffer at (at) and hints the range after it, returns bytes read */
+APOLLO_DEF size_t fsi_readerFill(fsi_Reader *reader, char *at, size_t n) {
+  size_t got = 0;
+  if (reader->file.tag == 2) {
+    got = fsi_descRead(reader->file.fileDesc, at, n, reader->position);
+  } else {
+    got = fread(at, 1, n, reader->file.fileHandle);
+  }
+  reader->position += got;
+  if (got < n) reader->eof = true;
+
+#if defined(POSIX_FADV_WILLNEED)
+  if (!reader->eof) {
+    int fd = reader->file.tag == 2 ? (int)reader->file.fileDesc : fileno(reader->file.fileHandle);
+    posix_fadvise(fd, (off_t)reader->position, (off_t)n, POSIX_FADV_WILLNEED);
+  }
+#endif
+  return got;
+}
+
+APOLLO_DEF bool fsi_readerInit(fsi_Reader *reader, fsi_File file, void *buffer, size_t capacity) {
+  memset(reader, 0, sizeof(fsi_Reader));
+  reader->file = file;
+  if (!(file.tag)) {
+    if (!fsi_FileOpen(file.filePath, FSI_OPEN_READ, &reader->file)) return false;
+    reader->ownsFile = true;
+  }
+
+  reader->buffer = (char*)buffer;
+  reader->capacity = capacity;
+  if (reader->buffer == NULL) {
+    reader->buffer = (char*)malloc(capacity);
+    reader->ownsBuffer = true;
+    if (reader->buffer == NULL) {
+      fsi_readerFree(reader);
+      return false;
+    }
+  }
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+  int fd = reader->file.tag == 2 ? (int)reader->file.fileDesc : fileno(reader->file.fileHandle);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  return true;
+}
+
+APOLLO_DEF void fsi_readerFree(fsi_Reader *reader) {
+  if (reader->ownsFile) fsi_FileClose(reader->file);
+  if (reader->ownsBuffer) free(reader->buffer);
+  memset(reader, 0, sizeof(fsi_Reader));
+}
+
+APOLLO_DEF StrView fsi_readerNext(fsi_Reader *reader) {
+  StrView ret = {0};
+  if (reader->eof) return ret;
+  size_t chunk = reader->capacity / 2;
+  char *at = reader->buffer + reader->half * chunk;
+  reader->half ^= 1;
+  ret.data = at;
+  ret.size = fsi_readerFill(reader, at, chunk);
+  return ret;
+}
+
+APOLLO_DEF bool fsi_readerRecord(fsi_Reader *reader, char delim, StrView *record) {
+  for (;;) {
+    char *begin = reader->buffer + reader->begin;
+    size_t left = reader->end - reader->begin;
+    char *found = left ? (char*)memchr(begin, delim, left) : NULL;
+    if (found != NULL) {
+      record->data = begin;
+      record->size = (size_t)(found - begin);
+      reader->begin += record->size + 1;
+      return true;
+    }
+
+    if (reader->eof || (reader->begin == 0 && reader->end == reader->capacity)) {
+      if (left == 0) return false;
+      record->data = begin;
+      record->size = left;
+      reader->begin = reader->end;
+      return true;
+    }
+
+    if (reader->begin != 0) {
+      memmove(reader->buffer, begin, left);
+      reader->begin = 0;
+      reader->end = left;
+    }
+    reader->end += fsi_readerFill(reader, reader->buffer + reader->end, reader->capacity - reader->end);
+  }
+}
+
+/* Runs one request synchronously, the result follows io_uring: bytes or -errno */
+APOLLO_DEF void fsi_ioRun(fsi_IORequest *request) {
+#if defined(_WIN32)
+  intptr_t desc = request->file.tag == 2 ? request->file.fileDesc : _get_osfhandle(_fileno(request->file.fileHandle));
+  request->result = (intptr_t)(request->op == FSI_IO_WRITE
+    ? fsi_descWrite(desc, request->buffer, request->size, request->offset)
+    : fsi_descRead(desc, request->buffer, request->size, request->offset));
+#else
+  int fd = request->file.tag == 2 ? (int)request->file.fileDesc : fileno(request->file.fileHandle);
+  ssize_t ret;
+  do {
+    ret = request->op == FSI_IO_WRITE
+      ? pwrite(fd, request->buffer, request->size, (off_t)request->offset)
+      : pread(fd, request->buffer, request->size, (off_t)request->offset);
+  } while (ret < 0 && errno == EINTR);
+  request->result = ret < 0 ? -(intptr_t)errno : (intptr_t)ret;
+#endif
+}
+
+/*
+  Thread pool / synchronous backend, three rings of depth requests:
+  queued (not submitted), pending (submitted, not started), finished (not reaped)
+*/
+typedef struct {
+  fsi_IORequest **queued;
+  fsi_IORequest **pending;
+  fsi_IORequest **finished;
+  unsigned pendingHead, pendingCount;
+  unsigned finishedHead, finishedCount;
+  bool stop;
+#if !defined(_WIN32)
+  pthread_mutex_t lock;
+  pthread_cond_t work;
+  pthread_cond_t done;
+  pthread_t threads[FSI_IO_THREAD_COUNT];
+  unsigned threadCount;
+#endif
+} fsi_IOPool;
+
+#if !defined(_WIN32)
+APOLLO_DEF void *fsi_ioWorker(void *data) {
+  fsi_IO *io = (fsi_IO*)data;
+  fsi_IOPool *pool = (fsi_IOPool*)io->state;
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (pool->pendingCount == 0 && !pool->stop) pthread_cond_wait(&pool->work, &pool->lock);
+    if (pool->pendingCount == 0) break;
+    fsi_IORequest *request = pool->pending[pool->pendingHead];
+    pool->pendingHead = (pool->pendingHead + 1) % io->depth;
+    pool->pendingCount--;
+    pthread_mutex_unlock(&pool->lock);
+
+    fsi_ioRun(request);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->finished[(pool->finishedHead + pool->finishedCount) % io->depth] = request;
+    pool->finishedCount++;
+    pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+#endif
+
+APOLLO_DEF bool fsi_ioPoolInit(fsi_IO *io, bool threads) {
+  fsi_IOPool *pool = (fsi_IOPool*)calloc(1, sizeof(fsi_IOPool) + sizeof(fsi_IORequest*) * io->depth * 3);
+  if (pool == NULL) return false;
+  pool->queued = (fsi_IORequest**)(pool + 1);
+  pool->pending = pool->queued + io->depth;
+  pool->finished = pool->pending + io->depth;
+  io->state = pool;
+  io->backend = FSI_IO_SYNC;
+#if !defined(_WIN32)
+  if (!threads) return true;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  io->backend = FSI_IO_THREADS;
+  for (; pool->threadCount < FSI_IO_THREAD_COUNT; pool->threadCount++) {
+    if (pthread_create(&pool->threads[pool->threadCount], NULL, fsi_ioWorker, io) != 0) break;
+  }
+  if (pool->threadCount == 0) {
+    fsi_ioFree(io);
+    return false;
+  }
+#endif
+  return true;
+}
+
+APOLLO_DEF unsigned fsi_ioPoolSubmit(fsi_IO *io) {
+  fsi_IOPool *pool = (fsi_IOPool*)io->state;
+  unsigned count = io->queued;
+  if (io->backend == FSI_IO_SYNC) {
+    for (unsigned i=0; i<count; i++) {
+      fsi_ioRun(pool->queued[i]);
+      pool->finished[(pool->finishedHead + pool->finishedCount++) % io->depth] = pool->queued[i];
+    }
+    return count;
+  }
+#if !defined(_WIN32)
+  pthread_mutex_lock(&pool->lock);
+  for (unsigned i=0; i<count; i++) {
+    pool->pending[(pool->pendingHead + pool->pendingCount++) % io->depth] = pool->queued[i];
+  }
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+#endif
+  return count;
+}
+
+APOLLO_DEF unsigned fsi_ioPoolComplete(fsi_IO *io, fsi_IORequest **done, unsigned max, bool wait) {
+  fsi_IOPool *pool = (fsi_IOPool*)io->state;
+  unsigned count = 0;
+#if !defined(_WIN32)
+  if (io->backend == FSI_IO_THREADS) {
+    pthread_mutex_lock(&pool->lock);
+    while (wait && pool->finishedCount == 0) pthread_cond_wait(&pool->done, &pool->lock);
+  }
+#endif
+  for (; count < max && pool->finishedCount > 0; count++) {
+    done[count] = pool->finished[pool->finishedHead];
+    pool->finishedHead = (pool->finishedHead + 1) % io->depth;
+    pool->finishedCount--;
+  }
+#if !defined(_WIN32)
+  if (io->backend == FSI_IO_THREADS) pthread_mutex_unlock(&pool->lock);
+#endif
+  return count;
+}
+
+APOLLO_DEF void fsi_ioPoolFree(fsi_IO *io) {
+  fsi_IOPool *pool = (fsi_IOPool*)io->state;
+#if !defined(_WIN32)
+  if (io->backend == FSI_IO_THREADS) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (unsigned i=0; i<pool->threadCount; i++) pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+  }
+#endif
+  free(pool);
+}
+
+#if defined(__linux__)
+/* io_uring backend through the raw syscalls, rings are shared with the kernel */
+typedef struct {
+  int fd;
+  void *sqRing;
+  void *cqRing;
+  struct io_uring_sqe *sqes;
+  size_t sqRingSize;
+  size_t cqRingSize;
+  size_t sqesSize;
+  unsigned *sqTail;
+  unsigned *sqMask;
+  unsigned *sqArray;
+  unsigned *cqHead;
+  unsigned *cqTail;
+  unsigned *cqMask;
+  struct io_uring_cqe *cqes;
+  unsigned tail;
+} fsi_IORing;
+
+APOLLO_DEF bool fsi_ioRingInit(fsi_IO *io) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = (int)syscall(__NR_io_uring_setup, io->depth, &params);
+  if (fd < 0) return false;
+
+  fsi_IORing *ring = (fsi_IORing*)calloc(1, sizeof(fsi_IORing));
+  if (ring == NULL) {
+    close(fd);
+    return false;
+  }
+  ring->fd = fd;
+  ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cqRingSize > ring->sqRingSize) ring->sqRingSize = ring->cqRingSize;
+    ring->cqRingSize = ring->sqRingSize;
+  }
+
+  ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  ring->cqRing = ring->sqRing;
+  if (ring->sqRing != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+    ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  }
+  ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  io->state = ring;
+  io->backend = FSI_IO_URING;
+  if (ring->sqRing == MAP_FAILED || ring->cqRing == MAP_FAILED || ring->sqes == MAP_FAILED) {
+    fsi_ioFree(io);
+    return false;
+  }
+
+  char *sq = (char*)ring->sqRing, *cq = (char*)ring->cqRing;
+  ring->sqTail = (unsigned*)(sq + params.sq_off.tail);
+  ring->sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+  ring->sqArray = (unsigned*)(sq + params.sq_off.array);
+  ring->cqHead = (unsigned*)(cq + params.cq_off.head);
+  ring->cqTail = (unsigned*)(cq + params.cq_off.tail);
+  ring->cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+  ring->tail = *ring->sqTail;
+  return true;
+}
+
+APOLLO_DEF void fsi_ioRingQueue(fsi_IO *io, fsi_IORequest *request) {
+  fsi_IORing *ring = (fsi_IORing*)io->state;
+  unsigned idx = ring->tail & *ring->sqMask;
+  struct io_uring_sqe *sqe = &ring->sqes[idx];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = request->op == FSI_IO_WRITE ? IORING_OP_WRITE : IORING_OP_READ;
+  sqe->fd = request->file.tag == 2 ? (int)request->file.fileDesc : fileno(request->file.fileHandle);
+  sqe->addr = (uint64_t)(uintptr_t)request->buffer;
+  sqe->len = (uint32_t)request->size;
+  sqe->off = request->offset;
+  sqe->user_data = (uint64_t)(uintptr_t)request;
+  ring->sqArray[idx] = idx;
+  ring->tail++;
+}
+
+APOLLO_DEF unsigned fsi_ioRingSubmit(fsi_IO *io) {
+  fsi_IORing *ring = (fsi_IORing*)io->state;
+  __atomic_store_n(ring->sqTail, ring->tail, __ATOMIC_RELEASE);
+  unsigned count = io->queued;
+  while (count > 0) {
+    int ret = (int)syscall(__NR_io_uring_enter, ring->fd, count, 0, 0, NULL, 0);
+    if (ret < 0 && errno == EINTR) continue;
+    if (ret <= 0) break;
+    count -= (unsigned)ret;
+  }
+  return io->queued - count;
+}
+
+APOLLO_DEF unsigned fsi_ioRingComplete(fsi_IO *io, fsi_IORequest **done, unsigned max, bool wait) {
+  fsi_IORing *ring = (fsi_IORing*)io->state;
+  unsigned head = *ring->cqHead;
+  unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+  while (wait && head == tail) {
+    syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+  }
+  unsigned count = 0;
+  for (; count < max && head != tail; head++, count++) {
+    struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cqMask];
+    done[count] = (fsi_IORequest*)(uintptr_t)cqe->user_data;
+    done[count]->result = cqe->res;
+  }
+  __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+  return count;
+}
+
+APOLLO_DEF void fsi_ioRingFree(fsi_IO *io) {
+  fsi_IORing *ring = (fsi_IORing*)io->state;
+  if (ring->sqes != NULL && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqesSize);
+  if (ring->cqRing != NULL && ring->cqRing != MAP_FAILED && ring->cqRing != ring->sqRing) munmap(ring->cqRing, ring->cqRingSize);
+  if (ring->sqRing != NULL && ring->sqRing != MAP_FAILED) munmap(ring->sqRing, ring->sqRingSize);
+  close(ring->fd);
+  free(ring);
+}
+#endif
+
+APOLLO_DEF bool fsi_ioInit(fsi_IO *io, unsigned depth, uint8_t backend) {
+  memset(io, 0, sizeof(fsi_IO));
+  io->depth = depth ? depth : 1;
+#if defined(__linux__)
+  if (backend == FSI_IO_AUTO || backend == FSI_IO_URING) {
+    if (fsi_ioRingInit(io)) return true;
+    if (backend == FSI_IO_URING) return false;
+  }
+#endif
+#if defined(_WIN32)
+  return backend == FSI_IO_URING ? false : fsi_ioPoolInit(io, false);
+#else
+  if (backend == FSI_IO_URING) return false;
+  return fsi_ioPoolInit(io, backend != FSI_IO_SYNC);
+#endif
+}
+
+APOLLO_DEF void fsi_ioFree(fsi_IO *io) {
+  if (io->state == NULL) return;
+  fsi_IORequest *drain[64];
+  // fsi_ioComplete takes the reaped requests off inFlight, queued ones never reached the kernel / workers
+  while (io->inFlight > 0) fsi_ioComplete(io, drain, 64, true);
+#if defined(__linux__)
+  if (io->backend == FSI_IO_URING) fsi_ioRingFree(io);
+  else fsi_ioPoolFree(io);
+#else
+  fsi_ioPoolFree(io);
+#endif
+  io->state = NULL;
+}
+
+APOLLO_DEF bool fsi_ioQueue(fsi_IO *io, fsi_IORequest *request) {
+  if (!(request->file.tag) || io->queued + io->inFlight >= io->depth) return false;
+  if (request->size > UINT32_MAX) return false;
+#if defined(__linux__)
+  if (io->backend == FSI_IO_URING) fsi_ioRingQueue(io, request);
+  else ((fsi_IOPool*)io->state)->queued[io->queued] = request;
+#else
+  ((fsi_IOPool*)io->state)->queued[io->queued] = request;
+#endif
+  io->queued++;
+  return true;
+}
+
+APOLLO_DEF unsigned fsi_ioSubmit(fsi_IO *io) {
+  if (io->queued == 0) return 0;
+#if defined(__linux__)
+  unsigned count = io->backend == FSI_IO_URING ? fsi_ioRingSubmit(io) : fsi_ioPoolSubmit(io);
+#else
+  unsigned count = fsi_ioPoolSubmit(io);
+#endif
+  // unsubmitted io_uring entries stay in the submission ring, the next submit retries them
+  io->inFlight += count;
+  io->queued -= count;
+  return count;
+}
+
+APOLLO_DEF unsigned fsi_ioComplete(fsi_IO *io, fsi_IORequest **done, unsigned max, bool wait) {
+  if (io->inFlight == 0) return 0;
+#if defined(__linux__)
+  unsigned count = io->backend == FSI_IO_URING
+    ? fsi_ioRingComplete(io, done, max, wait)
+    : fsi_ioPoolComplete(io, done, max, wait);
+#else
+  unsigned count = fsi_ioPoolComplete(io, done, max, wait);
+#endif
+  io->inFlight -= count;
+  return count;
+}
+
+APOLLO_DEF uint64_t fsi_writerClock(void) {
+#if defined(_WIN32)
+  return GetTickCount64();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+#endif
+}
+
+/* Writes (first) then (second) at the end of the file, the POSIX path gathers both in one writev */
+APOLLO_DEF bool fsi_writerPut(fsi_Writer *writer, const void *first, size_t firstLen, const void *second, size_t secondLen) {
+#if defined(_WIN32)
+  const char *parts[2] = {(const char*)first, (const char*)second};
+  size_t lens[2] = {firstLen, secondLen};
+  for (int i=0; i<2; i++) {
+    for (size_t done = 0; done < lens[i];) {
+      DWORD chunk = lens[i] - done > 0x40000000 ? 0x40000000 : (DWORD)(lens[i] - done), put = 0;
+      if (!WriteFile((HANDLE)writer->desc, parts[i] + done, chunk, &put, NULL) || put == 0) return false;
+      done += put;
+    }
+  }
+#else
+  struct iovec iov[2] = {{(void*)first, firstLen}, {(void*)second, secondLen}};
+  int at = 0;
+  while (at < 2) {
+    if (iov[at].iov_len == 0) {
+      at++;
+      continue;
+    }
+    ssize_t ret = writev((int)writer->desc, iov + at, 2 - at);
+    if (ret < 0 && errno == EINTR) continue;
+    if (ret <= 0) return false;
+    // a short write resumes inside whichever piece it stopped in
+    size_t put = (size_t)ret;
+    while (at < 2 && put >= iov[at].iov_len) put -= iov[at++].iov_len;
+    if (at < 2) {
+      iov[at].iov_base = (char*)iov[at].iov_base + put;
+      iov[at].iov_len -= put;
+    }
+  }
+#endif
+  return true;
+}
+
+APOLLO_DEF bool fsi_writerWrite(fsi_Writer *writer, const void *data, size_t n) {
+  if (!fsi_writerPut(writer, writer->buffer, writer->used, data, n)) {
+    writer->failed = true;
+    return false;
+  }
+  writer->used = 0;
+  if (writer->sync == FSI_SYNC_PERIODIC && fsi_writerClock() - writer->lastSync >= writer->interval) {
+    return fsi_writerCommit(writer);
+  }
+  return true;
+}
+
+APOLLO_DEF bool fsi_writerInit(fsi_Writer *writer, fsi_File file, void *buffer, size_t capacity, uint8_t sync, uint32_t interval) {
+  memset(writer, 0, sizeof(fsi_Writer));
+  writer->file = file;
+  if (!(file.tag)) {
+    if (!fsi_FileOpen(file.filePath, FSI_OPEN_APPEND, &writer->file)) return false;
+    writer->ownsFile = true;
+  }
+
+  // every write goes through the descriptor at its offset, which starts at the end of the file
+#if defined(_WIN32)
+  if (writer->file.tag == 1) fflush(writer->file.fileHandle);
+  writer->desc = writer->file.tag == 2 ? writer->file.fileDesc : _get_osfhandle(_fileno(writer->file.fileHandle));
+  LARGE_INTEGER zero = {0};
+  SetFilePointerEx((HANDLE)writer->desc, zero, NULL, FILE_END);
+#else
+  if (writer->file.tag == 1) fflush(writer->file.fileHandle);
+  writer->desc = writer->file.tag == 2 ? writer->file.fileDesc : fileno(writer->file.fileHandle);
+  lseek((int)writer->desc, 0, SEEK_END);
+#endif
+
+  writer->buffer = (char*)buffer;
+  writer->capacity = capacity;
+  writer->sync = sync;
+  writer->interval = interval;
+  writer->lastSync = fsi_writerClock();
+  if (writer->buffer == NULL) {
+    writer->buffer = (char*)malloc(capacity);
+    writer->ownsBuffer = true;
+    if (writer->buffer == NULL) {
+      fsi_writerFree(writer);
+      return false;
+    }
+  }
+  return true;
+}
+
+APOLLO_DEF bool fsi_writerAppend(fsi_Writer *writer, const void *data, size_t n) {
+  if (writer->failed) return false;
+  if (n <= writer->capacity - writer->used) {
+    memcpy(writer->buffer + writer->used, data, n);
+    writer->used += n;
+  } else if (!fsi_writerWrite(writer, data, n)) {
+    return false;
+  }
+
+  writer->records++;
+  if (writer->sync == FSI_SYNC_GROUP && writer->records >= writer->interval) return fsi_writerCommit(writer);
+  return true;
+}
+
+APOLLO_DEF bool fsi_writerFlush(fsi_Writer *writer) {
+  if (writer->failed) return false;
+  return writer->used == 0 || fsi_writerWrite(writer, NULL, 0);
+}
+
+APOLLO_DEF bool fsi_writerCommit(fsi_Writer *writer) {
+  if (writer->failed) return false;
+  if (writer->used > 0 && !fsi_writerPut(writer, writer->buffer, writer->used, NULL, 0)) {
+    writer->failed = true;
+    return false;
+  }
+  writer->used = 0;
+
+#if defined(_WIN32)
+  bool synced = FlushFileBuffers((HANDLE)writer->desc);
+#elif defined(__APPLE__)
+  bool synced = fsync((int)writer->desc) == 0;
+#else
+  bool synced = fdatasync((int)writer->desc) == 0;
+#endif
+  if (!synced) {
+    writer->failed = true;
+    return false;
+  }
+  writer->records = 0;
+  writer->lastSync = fsi_writerClock();
+  return true;
+}
+
+APOLLO_DEF bool fsi_writerFree(fsi_Writer *writer) {
+  bool ok = writer->buffer == NULL || (writer->sync == FSI_SYNC_NONE ? fsi_writerFlush(writer) : fsi_writerCommit(writer));
+  if (writer->ownsFile) fsi_FileClose(writer->file);
+  if (writer->ownsBuffer) free(writer->buffer);
+  memset(writer, 0, sizeof(fsi_Writer));
+  return ok;
+}
+
 #endif
\ No newline at end of file
@@ -7,34 +7,66 @@
   % The hashtable is implemented as as set of macros that implement
     and give the respective type implementation
     the type is only used for the value field
-    all keys are of type char *.
+    all keys are byte strings, given as char * (NUL terminated) or as StrView (strview.h)
 
-  % The hashtable is of static size
-    altough can allocate more memory for handling collisions
+  % Every KVP caches the full 64 bit hash and the length of its key, so a chain walk rejects
+    mismatches with an integer compare and growing the table never calls the hash function
+
+  % The hashtable grows (doubling) once it holds more than capacity * HASHTABLE_MAX_LOAD keys,
+    keys are rehashed into the new buckets all at once, or (rehashStep != 0) a few buckets
+    on every put / del so a big table never stalls one operation, get never moves buckets
 
   % Collisions are handled by chaining
 
+  % Capacities are powers of two so a bucket is picked by masking the hash, the hash function
+    has to mix its low bits well (any of the built in ones below does)
+
   User defined macros:
     HASHTABLE_ALLOC(size) -> Default: malloc, can be redefined to use another allocator in the same signature of malloc()
     HASHTABLE_FREE(size) -> Default: free, can be redefined to use another allocator in the same signature of free()
+    HASHTABLE_NODE_ALLOC(size) -> Default: HASHTABLE_ALLOC, used for chain nodes only, which are always
+                                  sizeof(<type>_HashTable_KVP), so a fixed size pool (mempool.h) can back them
+    HASHTABLE_NODE_FREE(ptr) -> Default: HASHTABLE_FREE, used for chain nodes only
+    HASHTABLE_MAX_LOAD -> Default: 1.0, keys per bucket that triggers a resize (define before including)
+    HASHTABLE_HASH -> Default: hashtable_hashWy, used by init when (hash) is NULL (define before including)
+    HASHTABLE_BATCH -> Default: 16, keys hashed and prefetched together by getMany / putMany
+    HASHTABLE_ARENA -> Default: undefined, define before including to get hashtable_initArena, includes memseg.h
+                       so the translation unit also needs MEMSEG_IMPLEMENTATION
 
   Types:
     % Types with <type> are generated by macros and thus can be getted by a macro
 
-  HashFunction -> int (*)(size_t cap, char *key)
+  HashFunctionEx -> uint64_t (*)(const char *key, size_t len, uint64_t seed), full 64 bit hash
 
   <type>_HashTable_KVP ->
     struct {
       char *key
+      size_t keyLen
+      uint64_t hash
       type value
       <type>_HashTable_KVP *next
     }
 
   <type>_HashTable ->
     struct {
-      HashFunction hash; 
+      HashFunctionEx hash;
+      uint64_t seed;                      -> passed to hash, 0 by default
       <type>_HashTable_KVP *items;
       size_t capacity;
+      size_t count;                       -> keys in the table
+      size_t rehashStep;                  -> buckets moved per put / del while resizing, 0 moves all at once
+      <type>_HashTable_KVP *oldItems;     -> buckets being drained by an incremental resize, NULL otherwise
+      size_t oldCapacity;
+      size_t rehashIdx;                   -> next bucket of oldItems to move
+      MemSeg *arena;                      -> only with HASHTABLE_ARENA, NULL unless made by initArena
+      <type>_HashTable_KVP *freeNodes;    -> only with HASHTABLE_ARENA, deleted nodes kept for reuse
+    }
+
+  <type>_HashTable_Iter ->
+    struct {
+      size_t bucket;                      -> next bucket to visit
+      int old;                            -> visiting the oldItems left by an incremental resize
+      <type>_HashTable_KVP *node;         -> next node of the current chain
     }
 
   Public Macros:
@@ -43,48 +75,276 @@
     
     HashTable(type) -> returns <type>_HashTable for declaration / cast
     HashTable_KVP(type) -> returns <type>_HashTable_KVP for declaration / cast
+    HashTable_Iter(type) -> returns <type>_HashTable_Iter for declaration / cast
 
     hashtable_init(type) -> returns init function for corresponding type
     hashtable_free(type) -> returns free function for corresponding type
+    hashtable_resize(type) -> returns resize function for corresponding type
+    hashtable_initArena(type) -> returns initArena function for corresponding type (HASHTABLE_ARENA only)
 
     hashtable_put(type) -> returns put function for corresponding type
     hashtable_get(type) -> returns get function for corresponding type
     hashtable_del(type) -> returns del function for corresponding type
 
+    hashtable_putView(type) / hashtable_getView(type) / hashtable_delView(type) ->
+      same as above taking a StrView key
+
+    hashtable_iter(type) / hashtable_next(type) -> return iteration functions for corresponding type
+    hashtable_putMany(type) / hashtable_getMany(type) -> return batch functions for corresponding type
+
   Private Macros:
     % These macros are used internaly please don't use
 
     HASHTABLE_IMPL_KVP
     HASHTABLE_IMPL_HT
-    HASHTABLE_IMPL_COLLIDES
+    HASHTABLE_IMPL_BUCKET
+    HASHTABLE_IMPL_NODE
+    HASHTABLE_IMPL_MIGRATE
+    HASHTABLE_IMPL_RESIZE
     HASHTABLE_IMPL_INIT
     HASHTABLE_IMPL_FREE
     HASHTABLE_IMPL_PUT
     HASHTABLE_IMPL_GET
     HASHTABLE_IMPL_DEL
+    HASHTABLE_IMPL_VIEW
+    HASHTABLE_IMPL_ITER
+    HASHTABLE_IMPL_BATCH
 
   Functions:
     % Underlying functions for hashtable operations
     
-    hashtable_init(<type>_HashTable *table, size_t size, HashFunction hash) ->
-      Allocates (size) amount of KVPs in (table), and sets the hashing function to (hash),
-      returns 1 on malloc error, 0 on success
+    hashtable_init(<type>_HashTable *table, size_t size, HashFunctionEx hash) ->
+      Allocates (size) amount of KVPs in (table) (rounded up to a power of two), and sets the
+      hashing function to (hash), HASHTABLE_HASH if NULL, returns 1 on malloc error, 0 on success
+
+    hashtable_initArena(<type>_HashTable *table, size_t size, HashFunctionEx hash, MemSeg *arena) ->
+      Same as hashtable_init but buckets, chain nodes and a copy of every key come from (arena),
+      so keys need not outlive the put and releasing the arena (memseg_free / memseg_rewind)
+      releases the whole table at once, deleted nodes are reused, their key copies are not,
+      returns 1 on allocation error, 0 on success (HASHTABLE_ARENA only)
 
     hashtable_free(<type>_HashTable *table) ->
-      Deallocates memory used by (table)
+      Deallocates memory used by (table), only forgets the memory of an arena table
+
+    hashtable_resize(<type>_HashTable *table, size_t size) ->
+      Moves (table) to (size) buckets (rounded up to a power of two) (incrementally if rehashStep != 0), finishing a resize
+      in progress first, returns 1 on malloc error (the table stays usable), 0 on success
 
     hashtable_put(<type>_HashTable *table, char *key, <type> value) ->
       Inserts / Updates (key) into (table) with value (value),
       returns 1 on malloc error, 0 on succes
 
     hashtable_get((<type>_HashTable *table, char *key) ->
-      Returns a the KVP associated with (key)
+      Returns a the KVP associated with (key), key is NULL if it is missing
 
     hashtable_del(type) ->
       Returns the KVP associated with (key) and deletes it from the table,
-      handles chains
+      handles chains, key is NULL if it was missing
+
+    hashtable_putView / hashtable_getView / hashtable_delView(<type>_HashTable *table, StrView key, ...) ->
+      Same as above, a put stores key.data so it must outlive the entry
+
+    hashtable_iter(<type>_HashTable *table) ->
+      Returns an iterator positioned before the first entry of (table)
+
+    hashtable_next(<type>_HashTable *table, <type>_HashTable_Iter *iter) ->
+      Returns the next entry of (table), NULL once all were visited, every entry is visited once
+      in no particular order as long as nothing is put / deleted meanwhile (values may be updated)
+        HashTable_Iter(int) it = hashtable_iter(int)(&table);
+        for (HashTable_KVP(int) *kvp; (kvp = hashtable_next(int)(&table, &it)) != NULL;) ...
+
+    hashtable_getMany(<type>_HashTable *table, char **keys, size_t count, <type>_HashTable_KVP *out) ->
+      Looks up (count) keys into out[i] (key NULL if missing), returns the amount found,
+      keys are hashed HASHTABLE_BATCH at a time and their buckets prefetched before any is probed
+      so the cache misses of a batch overlap instead of being paid one after another
+
+    hashtable_putMany(<type>_HashTable *table, char **keys, type *values, size_t count) ->
+      Puts (count) keys, growing the table once up front instead of repeatedly, hashed and
+      prefetched like getMany, returns 1 on malloc error (keys before the failing one were put), 0 on success
+
+  FLAT (OPEN ADDRESSING) HASHTABLE:
+    % Same keys / values as above but stored in one contiguous array, probed 16 slots
+      at a time with a control byte per slot holding 7 bits of the hash (SSE2 when available),
+      so a lookup is usually one group compare and one key compare
+
+    % No allocation per insert, the table grows (doubling) when 7/8 full
+
+  Types:
+    <type>_FlatHashTable_Slot ->
+      struct {
+        char *key
+        size_t keyLen
+        type value
+      }
+
+    <type>_FlatHashTable ->
+      struct {
+        HashFunctionEx hash;
+        uint64_t seed;
+        uint8_t *ctrl;
+        <type>_FlatHashTable_Slot *slots;
+        size_t capacity;
+        size_t count;
+        size_t growthLeft;
+      }
+
+  Public Macros:
+    FLATHASHTABLE_IMPL(type) / FLATHASHTABLE_DECL(type), FlatHashTable(type), FlatHashTable_Slot(type)
+    flathashtable_init(type), flathashtable_free(type), flathashtable_put(type),
+    flathashtable_get(type), flathashtable_del(type),
+    flathashtable_putView(type), flathashtable_getView(type), flathashtable_delView(type),
+    flathashtable_next(type)
+
+  Functions:
+    flathashtable_init(<type>_FlatHashTable *table, size_t size, HashFunctionEx hash) ->
+      Allocates room for at least (size) slots (power of two, minimum 16), returns 1 on malloc error
+
+    flathashtable_free(<type>_FlatHashTable *table) ->
+      Deallocates memory used by (table)
+
+    flathashtable_put(<type>_FlatHashTable *table, char *key, <type> value) ->
+      Inserts / Updates (key), returns 1 on malloc error (when growing), 0 on success
+
+    flathashtable_get(<type>_FlatHashTable *table, char *key) ->
+      Returns a pointer to the slot of (key), NULL if missing, valid until the next put
+
+    flathashtable_del(<type>_FlatHashTable *table, char *key) ->
+      Returns the slot of (key) and deletes it from the table, key is NULL if it was missing
+
+    flathashtable_putView / flathashtable_getView / flathashtable_delView ->
+      Same as above taking a StrView key
+
+    flathashtable_next(<type>_FlatHashTable *table, size_t *iter) ->
+      Returns the next full slot at or after *iter (start at 0) and moves *iter past it, NULL at the end,
+      skips 16 empty / deleted slots per control group compare
+
+  INTEGER MAP / SET:
+    % uint64_t keys stored inline (pointers as (uint64_t)(uintptr_t)ptr), no key pointer, no string
+      compare, an occupancy bitset so every key including 0 is usable, linear probing over a
+      power of two capacity kept under 3/4 full, deletion shifts the following entries back
+      instead of leaving tombstones, 8 bytes + sizeof(type) + 1 bit per slot
+
+  Types:
+    IntSet ->
+      struct {
+        uint64_t *keys;
+        uint64_t *used;                   -> bit i set when keys[i] holds a key
+        size_t capacity;
+        size_t count;
+        uint64_t seed;                    -> set right after init for untrusted keys (hashtable_randomSeed)
+      }
+
+    <type>_IntMap ->
+      struct {
+        uint64_t *keys;
+        uint64_t *used;
+        type *values;                     -> values[i] belongs to keys[i]
+        size_t capacity;
+        size_t count;
+        uint64_t seed;
+      }
+
+  Public Macros:
+    INTMAP_IMPL(type) / INTMAP_DECL(type), IntMap(type)
+    intmap_init(type), intmap_free(type), intmap_put(type), intmap_get(type), intmap_del(type), intmap_next(type)
+
+  Functions:
+    intmap_init(<type>_IntMap *map, size_t size) / intset_init(IntSet *set, size_t size) ->
+      Allocates room for (size) keys, returns 1 on malloc error, 0 on success
+
+    intmap_free(<type>_IntMap *map) / intset_free(IntSet *set) ->
+      Deallocates memory used by the map / set
+
+    intmap_put(<type>_IntMap *map, uint64_t key, type value) / intset_add(IntSet *set, uint64_t key) ->
+      Inserts / Updates (key), returns 1 on malloc error (when growing), 0 on success
+
+    intmap_get(<type>_IntMap *map, uint64_t key) ->
+      Returns a pointer to the value of (key), NULL if missing, valid until the next put / del
+
+    intset_has(IntSet *set, uint64_t key) ->
+      Returns whether (key) is in the set
+
+    intmap_del(<type>_IntMap *map, uint64_t key) / intset_del(IntSet *set, uint64_t key) ->
+      Removes (key), returns whether it was present
+
+    intmap_next(<type>_IntMap *map, size_t *iter, uint64_t *key) / intset_next(IntSet *set, size_t *iter, uint64_t *key) ->
+      Iteration starting with *iter = 0, stores the next key into (key) and returns a pointer to its
+      value (intset_next returns true), NULL / false at the end, skips 64 empty slots per bitset word
+
+  SHARDED (CONCURRENT) HASHTABLE:
+    % A chained table split into shards, each behind its own reader-writer lock (pthread_rwlock_t,
+      SRWLOCK on windows), the high bits of the hash pick the shard so threads touching different
+      keys rarely meet on a lock and readers of one shard never block each other
+
+    % Needs HASHTABLE_IMPL(type) of the same type, entries are returned by value so they stay
+      valid after the lock is released
+
+  Types:
+    <type>_ShardedHashTable_Shard ->
+      struct {
+        lock                              -> reader-writer lock of this shard
+        <type>_HashTable table;
+        char pad[64];                     -> keeps the locks of neighbouring shards off one cache line
+      }
+
+    <type>_ShardedHashTable ->
+      struct {
+        HashFunctionEx hash;
+        uint64_t seed;                    -> set before the first put, shared by all shards
+        <type>_ShardedHashTable_Shard *shards;
+        size_t shardCount;                -> power of two
+      }
+
+  Public Macros:
+    SHARDEDHASHTABLE_IMPL(type) / SHARDEDHASHTABLE_DECL(type), ShardedHashTable(type)
+    shardedhashtable_init(type), shardedhashtable_free(type), shardedhashtable_count(type),
+    shardedhashtable_put(type), shardedhashtable_get(type), shardedhashtable_del(type),
+    shardedhashtable_putView(type), shardedhashtable_getView(type), shardedhashtable_delView(type)
+
+  Functions:
+    shardedhashtable_init(<type>_ShardedHashTable *table, size_t shards, size_t size, HashFunctionEx hash) ->
+      Creates (shards) shards (rounded up to a power of two) of (size / shards) buckets each,
+      HASHTABLE_HASH if (hash) is NULL, returns 1 on malloc / lock error, 0 on success
+
+    shardedhashtable_free(<type>_ShardedHashTable *table) ->
+      Deallocates memory used by (table), no other thread may use it anymore
+
+    shardedhashtable_count(<type>_ShardedHashTable *table) ->
+      Returns the amount of keys, a snapshot when other threads are writing
+
+    shardedhashtable_put / shardedhashtable_get / shardedhashtable_del(..View) ->
+      Same as hashtable_put / get / del, safe to call from any thread
+
+  HASH FUNCTIONS:
+    % Any of these can be passed as the HashFunctionEx of either table
+
+    hashtable_hashWy(const char *key, size_t len, uint64_t seed) ->
+      wyhash, 64 bit multiply / xor mixing reading 8 bytes at a time, fast on every key length
+      and the default, with a secret (seed) it is the one to use for keys from the network
+
+    hashtable_hashCrc32(const char *key, size_t len, uint64_t seed) ->
+      CRC32C of the key run through a multiply / xor-shift finalizer, uses the crc32 instruction
+      when compiled with SSE4.2 (-msse4.2) or the ARMv8 CRC extension (HASHTABLE_CRC32 is then
+      defined) and a table driven fallback otherwise, CRC is linear so a seed does not stop
+      flooding, use it for trusted keys only
+
+    hashtable_randomSeed() ->
+      Returns 64 random bits (/dev/urandom when it exists, else time / address entropy),
+      set it as the (seed) of a table right after init to resist hash flooding:
+        hashtable_init(int)(&table, 64, NULL);
+        table.seed = hashtable_randomSeed();
 */
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "strview.h"
+
+#ifdef HASHTABLE_ARENA
+#include "memseg.h"
+#endif
+
 #ifndef APOLLO_DEF
 #define APOLLO_DEF extern
 #else
@@ -92,30 +352,163 @@
 #define APOLLO_DEF extern
 #endif
 
-#include <stddef.h>
-
 #define HASHTABLE_ALLOC(size) malloc(size)
 #define HASHTABLE_FREE(ptr) free(ptr)
+#define HASHTABLE_NODE_ALLOC(size) HASHTABLE_ALLOC(size)
+#define HASHTABLE_NODE_FREE(ptr) HASHTABLE_FREE(ptr)
 
-typedef int (*HashFunction)(size_t cap, char *key);
+#ifndef HASHTABLE_MAX_LOAD
+#define HASHTABLE_MAX_LOAD 1.0
+#endif
+
+typedef uint64_t (*HashFunctionEx)(const char *key, size_t len, uint64_t seed);
+
+/* Plain (not macro generated) functions are defined static below, so with the implementation
+   in this translation unit their extern prototypes are left out */
+#ifndef HASHTABLE_IMPLEMENTATION
+APOLLO_DEF uint64_t hashtable_hashWy(const char *key, size_t len, uint64_t seed);
+APOLLO_DEF uint64_t hashtable_hashCrc32(const char *key, size_t len, uint64_t seed);
+APOLLO_DEF uint64_t hashtable_randomSeed(void);
+#endif
+
+#ifndef HASHTABLE_HASH
+#define HASHTABLE_HASH hashtable_hashWy
+#endif
+
+#ifndef HASHTABLE_BATCH
+#define HASHTABLE_BATCH 16
+#endif
 
 #define HashTable(type) type##_HashTable
 #define HashTable_KVP(type) type##_HashTable_KVP
+#define HashTable_Iter(type) type##_HashTable_Iter
 
-#define HASHTABLE_DECL(type)                                                                     \
-typedef struct s_##type##_kvp type##_HashTable_KVP;                                              \
-typedef struct s_##type##_ht type##_HashTable;                                                   \
-APOLLO_DEF int type##_hashtable_init(HashTable(type) *table, size_t size, HashFunction hash);    \
-APOLLO_DEF void type##_hashtable_free(HashTable(type) *table);                                   \
-APOLLO_DEF int type##_hashtable_put(HashTable(type) *table, char *key, type value);              \
-APOLLO_DEF HashTable_KVP(type) type##_hashtable_get(HashTable(type) *table, char *key);          \
-APOLLO_DEF HashTable_KVP(type) type##_hashtable_del(HashTable(type) *table, char *key);          \
+#define HASHTABLE_DECL(type)                                                                                             \
+typedef struct s_##type##_kvp type##_HashTable_KVP;                                                                      \
+typedef struct s_##type##_ht type##_HashTable;                                                                           \
+typedef struct s_##type##_iter type##_HashTable_Iter;                                                                    \
+APOLLO_DEF int type##_hashtable_init(HashTable(type) *table, size_t size, HashFunctionEx hash);                          \
+APOLLO_DEF void type##_hashtable_free(HashTable(type) *table);                                                           \
+APOLLO_DEF int type##_hashtable_resize(HashTable(type) *table, size_t size);                                             \
+APOLLO_DEF int type##_hashtable_put(HashTable(type) *table, char *key, type value);                                      \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_get(HashTable(type) *table, char *key);                                  \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_del(HashTable(type) *table, char *key);                                  \
+APOLLO_DEF int type##_hashtable_putView(HashTable(type) *table, StrView key, type value);                                \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_getView(HashTable(type) *table, StrView key);                            \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_delView(HashTable(type) *table, StrView key);                            \
+APOLLO_DEF HashTable_Iter(type) type##_hashtable_iter(HashTable(type) *table);                                           \
+APOLLO_DEF HashTable_KVP(type) *type##_hashtable_next(HashTable(type) *table, HashTable_Iter(type) *iter);               \
+APOLLO_DEF size_t type##_hashtable_getMany(HashTable(type) *table, char **keys, size_t count, HashTable_KVP(type) *out); \
+APOLLO_DEF int type##_hashtable_putMany(HashTable(type) *table, char **keys, type *values, size_t count);                \
+HASHTABLE_DECL_ARENA(type)                                                                                               \
 
 #define hashtable_init(type) type##_hashtable_init
 #define hashtable_free(type) type##_hashtable_free
+#define hashtable_resize(type) type##_hashtable_resize
 #define hashtable_put(type)  type##_hashtable_put
 #define hashtable_get(type)  type##_hashtable_get
 #define hashtable_del(type)  type##_hashtable_del
+#define hashtable_putView(type) type##_hashtable_putView
+#define hashtable_getView(type) type##_hashtable_getView
+#define hashtable_delView(type) type##_hashtable_delView
+#define hashtable_initArena(type) type##_hashtable_initArena
+#define hashtable_iter(type)      type##_hashtable_iter
+#define hashtable_next(type)      type##_hashtable_next
+#define hashtable_getMany(type)   type##_hashtable_getMany
+#define hashtable_putMany(type)   type##_hashtable_putMany
+
+#ifdef HASHTABLE_ARENA
+#define HASHTABLE_DECL_ARENA(type) \
+APOLLO_DEF int type##_hashtable_initArena(HashTable(type) *table, size_t size, HashFunctionEx hash, MemSeg *arena);
+#else
+#define HASHTABLE_DECL_ARENA(type)
+#endif
+
+#define FlatHashTable(type) type##_FlatHashTable
+#define FlatHashTable_Slot(type) type##_FlatHashTable_Slot
+
+#define FLATHASHTABLE_DECL(type)                                                                            \
+typedef struct s_##type##_flat_slot type##_FlatHashTable_Slot;                                              \
+typedef struct s_##type##_flat_ht type##_FlatHashTable;                                                     \
+APOLLO_DEF int type##_flathashtable_init(FlatHashTable(type) *table, size_t size, HashFunctionEx hash);     \
+APOLLO_DEF void type##_flathashtable_free(FlatHashTable(type) *table);                                      \
+APOLLO_DEF int type##_flathashtable_put(FlatHashTable(type) *table, char *key, type value);                 \
+APOLLO_DEF FlatHashTable_Slot(type) *type##_flathashtable_get(FlatHashTable(type) *table, char *key);       \
+APOLLO_DEF FlatHashTable_Slot(type) type##_flathashtable_del(FlatHashTable(type) *table, char *key);        \
+APOLLO_DEF int type##_flathashtable_putView(FlatHashTable(type) *table, StrView key, type value);           \
+APOLLO_DEF FlatHashTable_Slot(type) *type##_flathashtable_getView(FlatHashTable(type) *table, StrView key); \
+APOLLO_DEF FlatHashTable_Slot(type) type##_flathashtable_delView(FlatHashTable(type) *table, StrView key);  \
+APOLLO_DEF FlatHashTable_Slot(type) *type##_flathashtable_next(FlatHashTable(type) *table, size_t *iter);   \
+
+#define flathashtable_init(type) type##_flathashtable_init
+#define flathashtable_free(type) type##_flathashtable_free
+#define flathashtable_put(type)  type##_flathashtable_put
+#define flathashtable_get(type)  type##_flathashtable_get
+#define flathashtable_del(type)  type##_flathashtable_del
+#define flathashtable_putView(type) type##_flathashtable_putView
+#define flathashtable_getView(type) type##_flathashtable_getView
+#define flathashtable_delView(type) type##_flathashtable_delView
+#define flathashtable_next(type) type##_flathashtable_next
+
+typedef struct {
+  uint64_t *keys;
+  uint64_t *used;
+  size_t capacity;
+  size_t count;
+  uint64_t seed;
+} IntSet;
+
+#ifndef HASHTABLE_IMPLEMENTATION
+APOLLO_DEF int intset_init(IntSet *set, size_t size);
+APOLLO_DEF void intset_free(IntSet *set);
+APOLLO_DEF int intset_add(IntSet *set, uint64_t key);
+APOLLO_DEF bool intset_has(IntSet *set, uint64_t key);
+APOLLO_DEF bool intset_del(IntSet *set, uint64_t key);
+APOLLO_DEF bool intset_next(IntSet *set, size_t *iter, uint64_t *key);
+#endif
+
+#define IntMap(type) type##_IntMap
+
+#define INTMAP_DECL(type)                                                            \
+typedef struct s_##type##_intmap type##_IntMap;                                      \
+APOLLO_DEF int type##_intmap_init(IntMap(type) *map, size_t size);                   \
+APOLLO_DEF void type##_intmap_free(IntMap(type) *map);                               \
+APOLLO_DEF int type##_intmap_put(IntMap(type) *map, uint64_t key, type value);       \
+APOLLO_DEF type *type##_intmap_get(IntMap(type) *map, uint64_t key);                 \
+APOLLO_DEF bool type##_intmap_del(IntMap(type) *map, uint64_t key);                  \
+APOLLO_DEF type *type##_intmap_next(IntMap(type) *map, size_t *iter, uint64_t *key); \
+
+#define intmap_init(type) type##_intmap_init
+#define intmap_free(type) type##_intmap_free
+#define intmap_put(type)  type##_intmap_put
+#define intmap_get(type)  type##_intmap_get
+#define intmap_del(type)  type##_intmap_del
+#define intmap_next(type) type##_intmap_next
+
+#define ShardedHashTable(type) type##_ShardedHashTable
+
+#define SHARDEDHASHTABLE_DECL(type)                                                                                          \
+typedef struct s_##type##_shard type##_ShardedHashTable_Shard;                                                               \
+typedef struct s_##type##_sharded_ht type##_ShardedHashTable;                                                                \
+APOLLO_DEF int type##_shardedhashtable_init(ShardedHashTable(type) *table, size_t shards, size_t size, HashFunctionEx hash); \
+APOLLO_DEF void type##_shardedhashtable_free(ShardedHashTable(type) *table);                                                 \
+APOLLO_DEF size_t type##_shardedhashtable_count(ShardedHashTable(type) *table);                                              \
+APOLLO_DEF int type##_shardedhashtable_put(ShardedHashTable(type) *table, char *key, type value);                            \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_get(ShardedHashTable(type) *table, char *key);                        \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_del(ShardedHashTable(type) *table, char *key);                        \
+APOLLO_DEF int type##_shardedhashtable_putView(ShardedHashTable(type) *table, StrView key, type value);                      \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_getView(ShardedHashTable(type) *table, StrView key);                  \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_delView(ShardedHashTable(type) *table, StrView key);                  \
+
+#define shardedhashtable_init(type)    type##_shardedhashtable_init
+#define shardedhashtable_free(type)    type##_shardedhashtable_free
+#define shardedhashtable_count(type)   type##_shardedhashtable_count
+#define shardedhashtable_put(type)     type##_shardedhashtable_put
+#define shardedhashtable_get(type)     type##_shardedhashtable_get
+#define shardedhashtable_del(type)     type##_shardedhashtable_del
+#define shardedhashtable_putView(type) type##_shardedhashtable_putView
+#define shardedhashtable_getView(type) type##_shardedhashtable_getView
+#define shardedhashtable_delView(type) type##_shardedhashtable_delView
 
 #ifdef HASHTABLE_IMPLEMENTATION
 
@@ -130,139 +523,1159 @@ APOLLO_DEF HashTable_KVP(type) type##_hashtable_del(HashTable(type) *table, char
 #define APOLLO_DEF static
 #endif
 
-#define HASHTABLE_IMPL(type)        \
-HASHTABLE_IMPL_KVP(type)            \
-HASHTABLE_IMPL_HT(type)             \
-HASHTABLE_IMPL_COLLIDES(type)       \
-HASHTABLE_IMPL_INIT(type)           \
-HASHTABLE_IMPL_FREE(type)           \
-HASHTABLE_IMPL_PUT(type)            \
-HASHTABLE_IMPL_GET(type)            \
-HASHTABLE_IMPL_DEL(type)            \
+/////////////////////////////////////////
+//           HASH FUNCTIONS            //
+/////////////////////////////////////////
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define HASHTABLE_CRC32
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define HASHTABLE_CRC32
+#endif
+
+#include <stdio.h>
+#include <time.h>
+
+APOLLO_DEF size_t hashtable_roundPow2(size_t size) {
+  size_t capacity = 1;
+  while (capacity < size) capacity *= 2;
+  return capacity;
+}
+
+APOLLO_DEF uint64_t hashtable_read64(const char *p) {
+  uint64_t ret;
+  memcpy(&ret, p, sizeof(ret));
+  return ret;
+}
+
+APOLLO_DEF uint64_t hashtable_read32(const char *p) {
+  uint32_t ret;
+  memcpy(&ret, p, sizeof(ret));
+  return ret;
+}
+
+/* 128 bit product of a and b, low half into a, high half into b */
+APOLLO_DEF void hashtable_mum(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = (__uint128_t)*a * *b;
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  *a = _umul128(*a, *b, b);
+#else
+  uint64_t ha = *a >> 32, la = (uint32_t)*a, hb = *b >> 32, lb = (uint32_t)*b;
+  uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+  uint64_t mid = (ll >> 32) + (uint32_t)hl + (uint32_t)lh;
+  *a = (mid << 32) | (uint32_t)ll;
+  *b = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+#endif
+}
+
+APOLLO_DEF uint64_t hashtable_mix(uint64_t a, uint64_t b) {
+  hashtable_mum(&a, &b);
+  return a ^ b;
+}
+
+#define HASHTABLE_WY0 0xa0761d6478bd642full
+#define HASHTABLE_WY1 0xe7037ed1a0b428dbull
+#define HASHTABLE_WY2 0x8ebc6af09c88c6e3ull
+#define HASHTABLE_WY3 0x589965cc75374cc3ull
+
+APOLLO_DEF uint64_t hashtable_hashWy(const char *key, size_t len, uint64_t seed) {
+  const char *p = key;
+  uint64_t a, b;
+  seed ^= hashtable_mix(seed ^ HASHTABLE_WY0, HASHTABLE_WY1);
+  if (len <= 16) {
+    if (len >= 4) {
+      size_t off = (len >> 3) << 2;
+      a = (hashtable_read32(p) << 32) | hashtable_read32(p + off);
+      b = (hashtable_read32(p + len - 4) << 32) | hashtable_read32(p + len - 4 - off);
+    } else if (len > 0) {
+      a = ((uint64_t)(uint8_t)p[0] << 16) | ((uint64_t)(uint8_t)p[len >> 1] << 8) | (uint8_t)p[len - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = hashtable_mix(hashtable_read64(p) ^ HASHTABLE_WY1, hashtable_read64(p + 8) ^ seed);
+        see1 = hashtable_mix(hashtable_read64(p + 16) ^ HASHTABLE_WY2, hashtable_read64(p + 24) ^ see1);
+        see2 = hashtable_mix(hashtable_read64(p + 32) ^ HASHTABLE_WY3, hashtable_read64(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = hashtable_mix(hashtable_read64(p) ^ HASHTABLE_WY1, hashtable_read64(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    a = hashtable_read64(p + i - 16);
+    b = hashtable_read64(p + i - 8);
+  }
+  a ^= HASHTABLE_WY1;
+  b ^= seed;
+  hashtable_mum(&a, &b);
+  return hashtable_mix(a ^ HASHTABLE_WY0 ^ len, b ^ HASHTABLE_WY1);
+}
+
+#if !defined(HASHTABLE_CRC32)
+/* CRC32C (Castagnoli, reflected 0x82F63B78) one nibble at a time, same result as the instruction */
+static const uint32_t hashtable_crcTable[16] = {
+  0x00000000, 0x105EC76F, 0x20BD8EDE, 0x30E349B1, 0x417B1DBC, 0x5125DAD3, 0x61C69362, 0x7198540D,
+  0x82F63B78, 0x92A8FC17, 0xA24BB5A6, 0xB21572C9, 0xC38D26C4, 0xD3D3E1AB, 0xE330A81A, 0xF36E6F75
+};
+#endif
+
+APOLLO_DEF uint64_t hashtable_hashCrc32(const char *key, size_t len, uint64_t seed) {
+  uint32_t crc = (uint32_t)seed ^ (uint32_t)(seed >> 32);
+  size_t i = 0;
+#if defined(__SSE4_2__)
+#if defined(__x86_64__) || defined(_M_X64)
+  uint64_t crc64 = crc;
+  for (; i + 8 <= len; i += 8) crc64 = _mm_crc32_u64(crc64, hashtable_read64(key + i));
+  crc = (uint32_t)crc64;
+#endif
+  for (; i < len; i++) crc = _mm_crc32_u8(crc, (uint8_t)key[i]);
+#elif defined(__ARM_FEATURE_CRC32)
+  for (; i + 8 <= len; i += 8) crc = __crc32cd(crc, hashtable_read64(key + i));
+  for (; i < len; i++) crc = __crc32cb(crc, (uint8_t)key[i]);
+#else
+  for (; i < len; i++) {
+    crc ^= (uint8_t)key[i];
+    crc = (crc >> 4) ^ hashtable_crcTable[crc & 0x0F];
+    crc = (crc >> 4) ^ hashtable_crcTable[crc & 0x0F];
+  }
+#endif
+  uint64_t h = ((uint64_t)crc ^ ((uint64_t)len << 32)) * 0x9E3779B97F4A7C15ull;
+  return h ^ (h >> 29);
+}
+
+APOLLO_DEF uint64_t hashtable_randomSeed(void) {
+  uint64_t seed = 0;
+  FILE *random = fopen("/dev/urandom", "rb");
+  if (random != NULL) {
+    size_t read = fread(&seed, sizeof(seed), 1, random);
+    fclose(random);
+    if (read == 1) return seed;
+  }
+  uint64_t local = (uint64_t)(uintptr_t)&seed;
+  return hashtable_mix((uint64_t)time(NULL) ^ HASHTABLE_WY2, (local ^ (uint64_t)clock()) ^ HASHTABLE_WY3);
+}
+
+/////////////////////////////////////////
+//          CHAINED HASHTABLE          //
+/////////////////////////////////////////
+
+/* Memory of a chained table, from the arena when it has one, else from HASHTABLE_ALLOC */
+#ifdef HASHTABLE_ARENA
+#define HASHTABLE_ARENA_FIELDS(type) MemSeg *arena; HashTable_KVP(type) *freeNodes;
+#define HASHTABLE_ARENA_SET(table, memseg) (table)->arena = (memseg); (table)->freeNodes = NULL;
+#define HASHTABLE_ARRAY_ALLOC(table, size) \
+  ((table)->arena != NULL ? memseg_allocAligned((table)->arena, size, _Alignof(max_align_t)) : HASHTABLE_ALLOC(size))
+#define HASHTABLE_ARRAY_FREE(table, ptr) if ((table)->arena == NULL) HASHTABLE_FREE(ptr)
+#define HASHTABLE_KEY_STORE(table, key, len) \
+  ((table)->arena != NULL ? hashtable_arenaKey((table)->arena, key, len) : (char*)(key))
+#define HASHTABLE_ARENA_NODE_ALLOC(table, T)                                     \
+  if ((table)->arena != NULL) {                                                  \
+    T *node = (table)->freeNodes;                                                \
+    if (node != NULL) (table)->freeNodes = node->next;                           \
+    else node = (T*)memseg_allocAligned((table)->arena, sizeof(T), _Alignof(T)); \
+    return node;                                                                 \
+  }
+#define HASHTABLE_ARENA_NODE_FREE(table, node) \
+  if ((table)->arena != NULL) {                \
+    (node)->next = (table)->freeNodes;         \
+    (table)->freeNodes = (node);               \
+    return;                                    \
+  }
+#define HASHTABLE_ARENA_FREE(table) \
+  if ((table)->arena != NULL) {     \
+    (table)->items = NULL;          \
+    (table)->oldItems = NULL;       \
+    (table)->capacity = 0;          \
+    (table)->count = 0;             \
+    return;                         \
+  }
+
+APOLLO_DEF char *hashtable_arenaKey(MemSeg *arena, const char *key, size_t len) {
+  char *copy = (char*)memseg_allocAligned(arena, len + 1, 1);
+  if (copy == NULL) return NULL;
+  memcpy(copy, key, len);
+  copy[len] = 0;
+  return copy;
+}
+
+#define HASHTABLE_IMPL_ARENA(type)                                                                                   \
+APOLLO_DEF int type##_hashtable_initArena(HashTable(type) *table, size_t size, HashFunctionEx hash, MemSeg *arena) { \
+  HASHTABLE_ARENA_SET(table, arena)                                                                                  \
+  return type##_hashtable_setup(table, size, hash);                                                                  \
+}
+#else
+#define HASHTABLE_ARENA_FIELDS(type)
+#define HASHTABLE_ARENA_SET(table, memseg)
+#define HASHTABLE_ARRAY_ALLOC(table, size) HASHTABLE_ALLOC(size)
+#define HASHTABLE_ARRAY_FREE(table, ptr) HASHTABLE_FREE(ptr)
+#define HASHTABLE_KEY_STORE(table, key, len) ((char*)(key))
+#define HASHTABLE_ARENA_NODE_ALLOC(table, T) (void)(table);
+#define HASHTABLE_ARENA_NODE_FREE(table, node) (void)(table);
+#define HASHTABLE_ARENA_FREE(table)
+#define HASHTABLE_IMPL_ARENA(type)
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HASHTABLE_PREFETCH(ptr) _mm_prefetch((const char*)(ptr), _MM_HINT_T0)
+#else
+#define HASHTABLE_PREFETCH(ptr) __builtin_prefetch(ptr)
+#endif
+
+/* Whether (kvp) holds the key (key, len) whose hash is (hash) */
+#define HASHTABLE_MATCHES(kvp, key, len, hash) \
+  ((kvp)->hash == (hash) && (kvp)->keyLen == (len) && memcmp((kvp)->key, (key), (len)) == 0)
+
+#define HASHTABLE_IMPL(type) \
+HASHTABLE_IMPL_KVP(type)     \
+HASHTABLE_IMPL_HT(type)      \
+HASHTABLE_IMPL_BUCKET(type)  \
+HASHTABLE_IMPL_NODE(type)    \
+HASHTABLE_IMPL_MIGRATE(type) \
+HASHTABLE_IMPL_RESIZE(type)  \
+HASHTABLE_IMPL_INIT(type)    \
+HASHTABLE_IMPL_FREE(type)    \
+HASHTABLE_IMPL_PUT(type)     \
+HASHTABLE_IMPL_GET(type)     \
+HASHTABLE_IMPL_DEL(type)     \
+HASHTABLE_IMPL_VIEW(type)    \
+HASHTABLE_IMPL_ITER(type)    \
+HASHTABLE_IMPL_BATCH(type)   \
+HASHTABLE_IMPL_ARENA(type)   \
 
 
 /* INTERNAL MACRO!!!!!, DO NOT USE */
-#define HASHTABLE_IMPL_KVP(type)    \
-typedef struct s_##type##_kvp {     \
-  char *key;                        \
-  type value;                       \
-  struct s_##type##_kvp *next;      \
-} HashTable_KVP(type);              \
+#define HASHTABLE_IMPL_KVP(type) \
+typedef struct s_##type##_kvp {  \
+  char *key;                     \
+  size_t keyLen;                 \
+  uint64_t hash;                 \
+  type value;                    \
+  struct s_##type##_kvp *next;   \
+} HashTable_KVP(type);           \
 
 /* INTERNAL MACRO!!!!!, DO NOT USE */
-#define HASHTABLE_IMPL_HT(type)     \
-typedef struct s_##type##_ht {      \
-  HashFunction hash;                \
-  HashTable_KVP(type) *items;       \
-  size_t capacity;                  \
-} HashTable(type);                  \
+#define HASHTABLE_IMPL_HT(type)  \
+typedef struct s_##type##_ht {   \
+  HashFunctionEx hash;           \
+  uint64_t seed;                 \
+  HashTable_KVP(type) *items;    \
+  size_t capacity;               \
+  size_t count;                  \
+  size_t rehashStep;             \
+  HashTable_KVP(type) *oldItems; \
+  size_t oldCapacity;            \
+  size_t rehashIdx;              \
+  HASHTABLE_ARENA_FIELDS(type)   \
+} HashTable(type);               \
+typedef struct s_##type##_iter { \
+  size_t bucket;                 \
+  int old;                       \
+  HashTable_KVP(type) *node;     \
+} HashTable_Iter(type);          \
 
 /* INTERNAL MACRO!!!!!, DO NOT USE */
-#define HASHTABLE_IMPL_COLLIDES(type)                                                             \
-APOLLO_DEF int type##_hashtable_collides(HashTable(type) *table, int hash, char *key) {           \
-  if (table->items[hash].key == NULL) return 0;                                                   \
-  else if (table->items[hash].key != NULL && strcmp(table->items[hash].key, key) == 0) return 0;  \
-  else if (table->items[hash].key != NULL && strcmp(table->items[hash].key, key) != 0) return 1;  \
-  else assert(0 && "UNREACHEABLE");                                                               \
+/* Bucket holding (hash) if present, buckets of oldItems before rehashIdx were already moved */
+#define HASHTABLE_IMPL_BUCKET(type)                                                              \
+APOLLO_DEF HashTable_KVP(type) *type##_hashtable_bucket(HashTable(type) *table, uint64_t hash) { \
+  if (table->oldItems != NULL) {                                                                 \
+    size_t old = (size_t)(hash & (table->oldCapacity - 1));                                      \
+    if (old >= table->rehashIdx) return &table->oldItems[old];                                   \
+  }                                                                                              \
+  return &table->items[hash & (table->capacity - 1)];                                            \
+}                                                                                                \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+/* Chain node allocation, an arena table reuses deleted nodes before taking new ones from the arena */
+#define HASHTABLE_IMPL_NODE(type)                                                              \
+APOLLO_DEF HashTable_KVP(type) *type##_hashtable_nodeAlloc(HashTable(type) *table) {           \
+  HASHTABLE_ARENA_NODE_ALLOC(table, HashTable_KVP(type))                                       \
+  return (HashTable_KVP(type)*)HASHTABLE_NODE_ALLOC(sizeof(HashTable_KVP(type)));              \
+}                                                                                              \
+APOLLO_DEF void type##_hashtable_nodeFree(HashTable(type) *table, HashTable_KVP(type) *node) { \
+  HASHTABLE_ARENA_NODE_FREE(table, node)                                                       \
+  HASHTABLE_NODE_FREE(node);                                                                   \
+}                                                                                              \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+/* Moves (buckets) buckets of oldItems into items, chain nodes are relinked, not reallocated */
+#define HASHTABLE_IMPL_MIGRATE(type)                                                \
+APOLLO_DEF int type##_hashtable_migrate(HashTable(type) *table, size_t buckets) {   \
+  while (table->oldItems != NULL && buckets > 0) {                                  \
+    HashTable_KVP(type) *old = &table->oldItems[table->rehashIdx];                  \
+    if (old->key != NULL) {                                                         \
+      HashTable_KVP(type) *head = &table->items[old->hash & (table->capacity - 1)]; \
+      if (head->key == NULL) {                                                      \
+        *head = *old;                                                               \
+        head->next = NULL;                                                          \
+      } else {                                                                      \
+        HashTable_KVP(type) *node = type##_hashtable_nodeAlloc(table);              \
+        if (node == NULL) return 1;                                                 \
+        *node = *old;                                                               \
+        node->next = head->next;                                                    \
+        head->next = node;                                                          \
+      }                                                                             \
+      HashTable_KVP(type) *current = old->next;                                     \
+      while (current != NULL) {                                                     \
+        HashTable_KVP(type) *next = current->next;                                  \
+        head = &table->items[current->hash & (table->capacity - 1)];                \
+        if (head->key == NULL) {                                                    \
+          *head = *current;                                                         \
+          head->next = NULL;                                                        \
+          type##_hashtable_nodeFree(table, current);                                \
+        } else {                                                                    \
+          current->next = head->next;                                               \
+          head->next = current;                                                     \
+        }                                                                           \
+        current = next;                                                             \
+      }                                                                             \
+    }                                                                               \
+    table->rehashIdx++;                                                             \
+    buckets--;                                                                      \
+    if (table->rehashIdx == table->oldCapacity) {                                   \
+      HASHTABLE_ARRAY_FREE(table, table->oldItems);                                 \
+      table->oldItems = NULL;                                                       \
+    }                                                                               \
+  }                                                                                 \
+  return 0;                                                                         \
+}                                                                                   \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define HASHTABLE_IMPL_RESIZE(type)                                                             \
+APOLLO_DEF int type##_hashtable_resize(HashTable(type) *table, size_t size) {                   \
+  if (table->oldItems != NULL && type##_hashtable_migrate(table, table->oldCapacity)) return 1; \
+  size = hashtable_roundPow2(size);                                                             \
+  size_t bs = sizeof(HashTable_KVP(type)) * size;                                               \
+  HashTable_KVP(type) *items = (HashTable_KVP(type)*) HASHTABLE_ARRAY_ALLOC(table, bs);         \
+  if (items == NULL) return 1;                                                                  \
+  memset(items, 0, bs);                                                                         \
+  table->oldItems = table->items;                                                               \
+  table->oldCapacity = table->capacity;                                                         \
+  table->rehashIdx = 0;                                                                         \
+  table->items = items;                                                                         \
+  table->capacity = size;                                                                       \
+  if (table->rehashStep == 0) return type##_hashtable_migrate(table, table->oldCapacity);       \
+  return 0;                                                                                     \
+}                                                                                               \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define HASHTABLE_IMPL_INIT(type)                                                                 \
+APOLLO_DEF int type##_hashtable_setup(HashTable(type) *table, size_t size, HashFunctionEx hash) { \
+  table->capacity = hashtable_roundPow2(size);                                                    \
+  table->hash = hash != NULL ? hash : HASHTABLE_HASH;                                             \
+  table->seed = 0;                                                                                \
+  table->count = 0;                                                                               \
+  table->rehashStep = 0;                                                                          \
+  table->oldItems = NULL;                                                                         \
+  table->oldCapacity = 0;                                                                         \
+  table->rehashIdx = 0;                                                                           \
+  size_t bs = sizeof(HashTable_KVP(type)) * table->capacity;                                      \
+  table->items = (HashTable_KVP(type)*) HASHTABLE_ARRAY_ALLOC(table, bs);                         \
+  if (table->items == NULL) return 1;                                                             \
+  memset(table->items, 0, bs);                                                                    \
+  return 0;                                                                                       \
+}                                                                                                 \
+APOLLO_DEF int type##_hashtable_init(HashTable(type) *table, size_t size, HashFunctionEx hash) {  \
+  HASHTABLE_ARENA_SET(table, NULL)                                                                \
+  return type##_hashtable_setup(table, size, hash);                                               \
 }                                                                                                 \
 
 /* INTERNAL MACRO!!!!!, DO NOT USE */
-#define HASHTABLE_COLLIDES(type) type##_hashtable_collides
+#define HASHTABLE_IMPL_FREE(type)                                                         \
+APOLLO_DEF void type##_hashtable_free(HashTable(type) *table) {                           \
+  HASHTABLE_ARENA_FREE(table)                                                             \
+  for (size_t i=0; i<table->capacity; i++) {                                              \
+    HashTable_KVP(type) *curr = table->items[i].next;                                     \
+    HashTable_KVP(type) *copy = curr;                                                     \
+    while (curr != NULL) {                                                                \
+      curr = curr->next;                                                                  \
+      HASHTABLE_NODE_FREE(copy);                                                          \
+      copy = curr;                                                                        \
+    }                                                                                     \
+  }                                                                                       \
+  for (size_t i=table->rehashIdx; table->oldItems != NULL && i<table->oldCapacity; i++) { \
+    HashTable_KVP(type) *curr = table->oldItems[i].next;                                  \
+    HashTable_KVP(type) *copy = curr;                                                     \
+    while (curr != NULL) {                                                                \
+      curr = curr->next;                                                                  \
+      HASHTABLE_NODE_FREE(copy);                                                          \
+      copy = curr;                                                                        \
+    }                                                                                     \
+  }                                                                                       \
+  if (table->oldItems != NULL) HASHTABLE_FREE(table->oldItems);                           \
+  HASHTABLE_FREE(table->items);                                                           \
+}                                                                                         \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+/* put / get / del of a key whose hash is already known, the char * and StrView versions wrap these */
+#define HASHTABLE_IMPL_PUT(type)                                                                                            \
+APOLLO_DEF int type##_hashtable_putHashed(HashTable(type) *table, const char *key, size_t len, uint64_t hash, type value) { \
+  if (table->oldItems != NULL)                                                                                              \
+    type##_hashtable_migrate(table, table->rehashStep ? table->rehashStep : table->oldCapacity);                            \
+  HashTable_KVP(type) *head = type##_hashtable_bucket(table, hash);                                                         \
+  HashTable_KVP(type) *current = head;                                                                                      \
+  for (; current != NULL && current->key != NULL; current = current->next) {                                                \
+    if (HASHTABLE_MATCHES(current, key, len, hash)) {                                                                       \
+      current->value = value;                                                                                               \
+      return 0;                                                                                                             \
+    }                                                                                                                       \
+  }                                                                                                                         \
+  char *stored = HASHTABLE_KEY_STORE(table, key, len);                                                                      \
+  if (stored == NULL) return 1;                                                                                             \
+  if (head->key != NULL) {                                                                                                  \
+    HashTable_KVP(type) *node = type##_hashtable_nodeAlloc(table);                                                          \
+    if (node == NULL) return 1;                                                                                             \
+    node->next = head->next;                                                                                                \
+    head->next = node;                                                                                                      \
+    head = node;                                                                                                            \
+  }                                                                                                                         \
+  head->key = stored;                                                                                                       \
+  head->keyLen = len;                                                                                                       \
+  head->hash = hash;                                                                                                        \
+  head->value = value;                                                                                                      \
+  table->count++;                                                                                                           \
+  if (table->oldItems == NULL && table->count > table->capacity * HASHTABLE_MAX_LOAD)                                       \
+    type##_hashtable_resize(table, table->capacity * 2);                                                                    \
+  return 0;                                                                                                                 \
+}                                                                                                                           \
+APOLLO_DEF int type##_hashtable_put(HashTable(type) *table, char *key, type value) {                                        \
+  size_t len = strlen(key);                                                                                                 \
+  return type##_hashtable_putHashed(table, key, len, table->hash(key, len, table->seed), value);                            \
+}                                                                                                                           \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define HASHTABLE_IMPL_GET(type)                                                                                                \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_getHashed(HashTable(type) *table, const char *key, size_t len, uint64_t hash) { \
+  HashTable_KVP(type) item = {0};                                                                                               \
+  HashTable_KVP(type) *current = type##_hashtable_bucket(table, hash);                                                          \
+  for (; current != NULL && current->key != NULL; current = current->next) {                                                    \
+    if (HASHTABLE_MATCHES(current, key, len, hash)) return *current;                                                            \
+  }                                                                                                                             \
+  return item;                                                                                                                  \
+}                                                                                                                               \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_get(HashTable(type) *table, char *key) {                                        \
+  size_t len = strlen(key);                                                                                                     \
+  return type##_hashtable_getHashed(table, key, len, table->hash(key, len, table->seed));                                       \
+}                                                                                                                               \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define HASHTABLE_IMPL_DEL(type)                                                                                                \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_delHashed(HashTable(type) *table, const char *key, size_t len, uint64_t hash) { \
+  HashTable_KVP(type) item = {0};                                                                                               \
+  if (table->oldItems != NULL)                                                                                                  \
+    type##_hashtable_migrate(table, table->rehashStep ? table->rehashStep : table->oldCapacity);                                \
+  HashTable_KVP(type) *head = type##_hashtable_bucket(table, hash);                                                             \
+  if (head->key == NULL) return item;                                                                                           \
+  if (HASHTABLE_MATCHES(head, key, len, hash)) {                                                                                \
+    item = *head;                                                                                                               \
+    HashTable_KVP(type) *collision = head->next;                                                                                \
+    if (collision == NULL) {                                                                                                    \
+      memset(head, 0, sizeof(HashTable_KVP(type)));                                                                             \
+    } else {                                                                                                                    \
+      *head = *collision;                                                                                                       \
+      type##_hashtable_nodeFree(table, collision);                                                                              \
+    }                                                                                                                           \
+  } else {                                                                                                                      \
+    HashTable_KVP(type) *previous = head;                                                                                       \
+    HashTable_KVP(type) *current = head->next;                                                                                  \
+    while (current != NULL && !HASHTABLE_MATCHES(current, key, len, hash)) {                                                    \
+      previous = current;                                                                                                       \
+      current = current->next;                                                                                                  \
+    }                                                                                                                           \
+    if (current == NULL) return item;                                                                                           \
+    item = *current;                                                                                                            \
+    previous->next = current->next;                                                                                             \
+    type##_hashtable_nodeFree(table, current);                                                                                  \
+  }                                                                                                                             \
+  table->count--;                                                                                                               \
+  item.next = NULL;                                                                                                             \
+  return item;                                                                                                                  \
+}                                                                                                                               \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_del(HashTable(type) *table, char *key) {                                        \
+  size_t len = strlen(key);                                                                                                     \
+  return type##_hashtable_delHashed(table, key, len, table->hash(key, len, table->seed));                                       \
+}                                                                                                                               \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define HASHTABLE_IMPL_VIEW(type)                                                                                    \
+APOLLO_DEF int type##_hashtable_putView(HashTable(type) *table, StrView key, type value) {                           \
+  return type##_hashtable_putHashed(table, key.data, key.size, table->hash(key.data, key.size, table->seed), value); \
+}                                                                                                                    \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_getView(HashTable(type) *table, StrView key) {                       \
+  return type##_hashtable_getHashed(table, key.data, key.size, table->hash(key.data, key.size, table->seed));        \
+}                                                                                                                    \
+APOLLO_DEF HashTable_KVP(type) type##_hashtable_delView(HashTable(type) *table, StrView key) {                       \
+  return type##_hashtable_delHashed(table, key.data, key.size, table->hash(key.data, key.size, table->seed));        \
+}                                                                                                                    \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+/* Walks items, then the buckets of oldItems not yet moved by an incremental resize */
+#define HASHTABLE_IMPL_ITER(type)                                                                           \
+APOLLO_DEF HashTable_Iter(type) type##_hashtable_iter(HashTable(type) *table) {                             \
+  (void)table;                                                                                              \
+  HashTable_Iter(type) iter = {0};                                                                          \
+  return iter;                                                                                              \
+}                                                                                                           \
+APOLLO_DEF HashTable_KVP(type) *type##_hashtable_next(HashTable(type) *table, HashTable_Iter(type) *iter) { \
+  while (iter->node == NULL) {                                                                              \
+    HashTable_KVP(type) *items = iter->old ? table->oldItems : table->items;                                \
+    size_t capacity = iter->old ? table->oldCapacity : table->capacity;                                     \
+    while (iter->bucket < capacity && items[iter->bucket].key == NULL) iter->bucket++;                      \
+    if (iter->bucket < capacity) {                                                                          \
+      iter->node = &items[iter->bucket++];                                                                  \
+    } else if (!iter->old && table->oldItems != NULL) {                                                     \
+      iter->old = 1;                                                                                        \
+      iter->bucket = table->rehashIdx;                                                                      \
+    } else {                                                                                                \
+      return NULL;                                                                                          \
+    }                                                                                                       \
+  }                                                                                                         \
+  HashTable_KVP(type) *current = iter->node;                                                                \
+  iter->node = current->next;                                                                               \
+  return current;                                                                                           \
+}                                                                                                           \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+/* Hashes a batch of keys and prefetches their buckets, then probes them in the same order */
+#define HASHTABLE_IMPL_BATCH(type)                                                                                        \
+APOLLO_DEF size_t type##_hashtable_getMany(HashTable(type) *table, char **keys, size_t count, HashTable_KVP(type) *out) { \
+  size_t lens[HASHTABLE_BATCH];                                                                                           \
+  uint64_t hashes[HASHTABLE_BATCH];                                                                                       \
+  size_t found = 0;                                                                                                       \
+  for (size_t base=0; base<count; base+=HASHTABLE_BATCH) {                                                                \
+    size_t n = count - base < HASHTABLE_BATCH ? count - base : HASHTABLE_BATCH;                                           \
+    for (size_t i=0; i<n; i++) {                                                                                          \
+      lens[i] = strlen(keys[base + i]);                                                                                   \
+      hashes[i] = table->hash(keys[base + i], lens[i], table->seed);                                                      \
+      HASHTABLE_PREFETCH(type##_hashtable_bucket(table, hashes[i]));                                                      \
+    }                                                                                                                     \
+    for (size_t i=0; i<n; i++) {                                                                                          \
+      out[base + i] = type##_hashtable_getHashed(table, keys[base + i], lens[i], hashes[i]);                              \
+      found += out[base + i].key != NULL;                                                                                 \
+    }                                                                                                                     \
+  }                                                                                                                       \
+  return found;                                                                                                           \
+}                                                                                                                         \
+APOLLO_DEF int type##_hashtable_putMany(HashTable(type) *table, char **keys, type *values, size_t count) {                \
+  size_t lens[HASHTABLE_BATCH];                                                                                           \
+  uint64_t hashes[HASHTABLE_BATCH];                                                                                       \
+  size_t needed = table->capacity;                                                                                        \
+  while ((table->count + count) > needed * HASHTABLE_MAX_LOAD) needed *= 2;                                               \
+  if (needed != table->capacity && type##_hashtable_resize(table, needed)) return 1;                                      \
+  for (size_t base=0; base<count; base+=HASHTABLE_BATCH) {                                                                \
+    size_t n = count - base < HASHTABLE_BATCH ? count - base : HASHTABLE_BATCH;                                           \
+    for (size_t i=0; i<n; i++) {                                                                                          \
+      lens[i] = strlen(keys[base + i]);                                                                                   \
+      hashes[i] = table->hash(keys[base + i], lens[i], table->seed);                                                      \
+      HASHTABLE_PREFETCH(type##_hashtable_bucket(table, hashes[i]));                                                      \
+    }                                                                                                                     \
+    for (size_t i=0; i<n; i++) {                                                                                          \
+      if (type##_hashtable_putHashed(table, keys[base + i], lens[i], hashes[i], values[base + i])) return 1;              \
+    }                                                                                                                     \
+  }                                                                                                                       \
+  return 0;                                                                                                               \
+}                                                                                                                         \
+
+/////////////////////////////////////////
+//      FLAT HASHTABLE (INTERNAL)      //
+/////////////////////////////////////////
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASHTABLE_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* Control bytes, a full slot holds the low 7 bits of its hash */
+#define HASHTABLE_CTRL_EMPTY ((uint8_t)0x80)
+#define HASHTABLE_CTRL_DELETED ((uint8_t)0xFE)
+#define HASHTABLE_GROUP 16
+
+APOLLO_DEF unsigned hashtable_ctz(uint32_t x) {
+#if defined(_MSC_VER)
+  unsigned long ret;
+  _BitScanForward(&ret, x);
+  return (unsigned)ret;
+#else
+  return (unsigned)__builtin_ctz(x);
+#endif
+}
+
+/* Bitmask of the slots of the group at ctrl whose control byte is value */
+APOLLO_DEF uint32_t hashtable_groupMatch(const uint8_t *ctrl, uint8_t value) {
+#if defined(HASHTABLE_SSE2)
+  __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)value)));
+#else
+  uint32_t mask = 0;
+  for (int i=0; i<HASHTABLE_GROUP; i++) mask |= (uint32_t)(ctrl[i] == value) << i;
+  return mask;
+#endif
+}
+
+/* Bitmask of the slots of the group at ctrl that are empty or deleted */
+APOLLO_DEF uint32_t hashtable_groupFree(const uint8_t *ctrl) {
+#if defined(HASHTABLE_SSE2)
+  return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+  uint32_t mask = 0;
+  for (int i=0; i<HASHTABLE_GROUP; i++) mask |= (uint32_t)(ctrl[i] >> 7) << i;
+  return mask;
+#endif
+}
+
+/* The first group is mirrored past the end so a group can be loaded from any slot */
+APOLLO_DEF void hashtable_setCtrl(uint8_t *ctrl, size_t capacity, size_t idx, uint8_t value) {
+  ctrl[idx] = value;
+  if (idx < HASHTABLE_GROUP) ctrl[capacity + idx] = value;
+}
+
+/* First empty or deleted slot on the probe sequence of hash */
+APOLLO_DEF size_t hashtable_findFree(const uint8_t *ctrl, size_t capacity, uint64_t hash) {
+  size_t mask = capacity - 1;
+  size_t pos = (size_t)(hash >> 7) & mask;
+  for (size_t step = HASHTABLE_GROUP;; pos = (pos + step) & mask, step += HASHTABLE_GROUP) {
+    uint32_t free = hashtable_groupFree(&ctrl[pos]);
+    if (free != 0) return (pos + hashtable_ctz(free)) & mask;
+  }
+}
+
+#define FLATHASHTABLE_IMPL(type) \
+FLATHASHTABLE_IMPL_SLOT(type)    \
+FLATHASHTABLE_IMPL_HT(type)      \
+FLATHASHTABLE_IMPL_FIND(type)    \
+FLATHASHTABLE_IMPL_REHASH(type)  \
+FLATHASHTABLE_IMPL_INIT(type)    \
+FLATHASHTABLE_IMPL_FREE(type)    \
+FLATHASHTABLE_IMPL_PUT(type)     \
+FLATHASHTABLE_IMPL_GET(type)     \
+FLATHASHTABLE_IMPL_DEL(type)     \
+FLATHASHTABLE_IMPL_VIEW(type)    \
+FLATHASHTABLE_IMPL_ITER(type)    \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_SLOT(type) \
+typedef struct s_##type##_flat_slot { \
+  char *key;                          \
+  size_t keyLen;                      \
+  type value;                         \
+} FlatHashTable_Slot(type);           \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_HT(type) \
+typedef struct s_##type##_flat_ht { \
+  HashFunctionEx hash;              \
+  uint64_t seed;                    \
+  uint8_t *ctrl;                    \
+  FlatHashTable_Slot(type) *slots;  \
+  size_t capacity;                  \
+  size_t count;                     \
+  size_t growthLeft;                \
+} FlatHashTable(type);              \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_FIND(type)                                                                                    \
+APOLLO_DEF ptrdiff_t type##_flathashtable_find(FlatHashTable(type) *table, const char *key, size_t len, uint64_t hash) { \
+  size_t mask = table->capacity - 1;                                                                                     \
+  size_t pos = (size_t)(hash >> 7) & mask;                                                                               \
+  for (size_t step = HASHTABLE_GROUP;; pos = (pos + step) & mask, step += HASHTABLE_GROUP) {                             \
+    uint32_t match = hashtable_groupMatch(&table->ctrl[pos], (uint8_t)(hash & 0x7F));                                    \
+    while (match != 0) {                                                                                                 \
+      size_t idx = (pos + hashtable_ctz(match)) & mask;                                                                  \
+      FlatHashTable_Slot(type) *slot = &table->slots[idx];                                                               \
+      if (slot->keyLen == len && memcmp(slot->key, key, len) == 0) return (ptrdiff_t)idx;                                \
+      match &= match - 1;                                                                                                \
+    }                                                                                                                    \
+    if (hashtable_groupMatch(&table->ctrl[pos], HASHTABLE_CTRL_EMPTY) != 0) return -1;                                   \
+  }                                                                                                                      \
+}                                                                                                                        \
 
 /* INTERNAL MACRO!!!!!, DO NOT USE */
-#define HASHTABLE_IMPL_INIT(type)                                                             \
-APOLLO_DEF int type##_hashtable_init(HashTable(type) *table, size_t size, HashFunction hash) {\
-  table->capacity = size;                                                                     \
-  table->hash = hash;                                                                         \
-  size_t bs = sizeof(HashTable_KVP(type)) * table->capacity;                                  \
-  table->items = (HashTable_KVP(type)*) HASHTABLE_ALLOC(bs);                                  \
-  if (table->items == NULL) return 1;                                                         \
-  memset(table->items, 0, bs);                                                                \
-  return 0;                                                                                   \
-}                                                                                             \
+#define FLATHASHTABLE_IMPL_REHASH(type)                                                    \
+APOLLO_DEF int type##_flathashtable_rehash(FlatHashTable(type) *table, size_t capacity) {  \
+  size_t bs = sizeof(FlatHashTable_Slot(type)) * capacity + capacity + HASHTABLE_GROUP;    \
+  FlatHashTable_Slot(type) *slots = (FlatHashTable_Slot(type)*) HASHTABLE_ALLOC(bs);       \
+  if (slots == NULL) return 1;                                                             \
+  uint8_t *ctrl = (uint8_t*)(slots + capacity);                                            \
+  memset(ctrl, HASHTABLE_CTRL_EMPTY, capacity + HASHTABLE_GROUP);                          \
+  for (size_t i=0; i<table->capacity; i++) {                                               \
+    if (table->ctrl[i] & 0x80) continue;                                                   \
+    uint64_t hash = table->hash(table->slots[i].key, table->slots[i].keyLen, table->seed); \
+    size_t idx = hashtable_findFree(ctrl, capacity, hash);                                 \
+    hashtable_setCtrl(ctrl, capacity, idx, (uint8_t)(hash & 0x7F));                        \
+    slots[idx] = table->slots[i];                                                          \
+  }                                                                                        \
+  if (table->slots != NULL) HASHTABLE_FREE(table->slots);                                  \
+  table->slots = slots;                                                                    \
+  table->ctrl = ctrl;                                                                      \
+  table->capacity = capacity;                                                              \
+  table->growthLeft = capacity - capacity / 8 - table->count;                              \
+  return 0;                                                                                \
+}                                                                                          \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_INIT(type)                                                                    \
+APOLLO_DEF int type##_flathashtable_init(FlatHashTable(type) *table, size_t size, HashFunctionEx hash) { \
+  size_t capacity = HASHTABLE_GROUP;                                                                     \
+  while (capacity < size) capacity *= 2;                                                                 \
+  memset(table, 0, sizeof(FlatHashTable(type)));                                                         \
+  table->hash = hash != NULL ? hash : HASHTABLE_HASH;                                                    \
+  return type##_flathashtable_rehash(table, capacity);                                                   \
+}                                                                                                        \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_FREE(type)                                   \
+APOLLO_DEF void type##_flathashtable_free(FlatHashTable(type) *table) { \
+  HASHTABLE_FREE(table->slots);                                         \
+  table->slots = NULL;                                                  \
+  table->ctrl = NULL;                                                   \
+  table->capacity = 0;                                                  \
+  table->count = 0;                                                     \
+}                                                                       \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_PUT(type)                                                                                                \
+APOLLO_DEF int type##_flathashtable_putHashed(FlatHashTable(type) *table, const char *key, size_t len, uint64_t hash, type value) { \
+  ptrdiff_t found = type##_flathashtable_find(table, key, len, hash);                                                               \
+  if (found >= 0) {                                                                                                                 \
+    table->slots[found].value = value;                                                                                              \
+    return 0;                                                                                                                       \
+  }                                                                                                                                 \
+  size_t idx = hashtable_findFree(table->ctrl, table->capacity, hash);                                                              \
+  if (table->growthLeft == 0 && table->ctrl[idx] == HASHTABLE_CTRL_EMPTY) {                                                         \
+    size_t capacity = table->capacity;                                                                                              \
+    if ((table->count + 1) * 16 > capacity * 7) capacity *= 2;                                                                      \
+    if (type##_flathashtable_rehash(table, capacity)) return 1;                                                                     \
+    idx = hashtable_findFree(table->ctrl, table->capacity, hash);                                                                   \
+  }                                                                                                                                 \
+  if (table->ctrl[idx] == HASHTABLE_CTRL_EMPTY) table->growthLeft--;                                                                \
+  hashtable_setCtrl(table->ctrl, table->capacity, idx, (uint8_t)(hash & 0x7F));                                                     \
+  table->slots[idx].key = (char*)key;                                                                                               \
+  table->slots[idx].keyLen = len;                                                                                                   \
+  table->slots[idx].value = value;                                                                                                  \
+  table->count++;                                                                                                                   \
+  return 0;                                                                                                                         \
+}                                                                                                                                   \
+APOLLO_DEF int type##_flathashtable_put(FlatHashTable(type) *table, char *key, type value) {                                        \
+  size_t len = strlen(key);                                                                                                         \
+  return type##_flathashtable_putHashed(table, key, len, table->hash(key, len, table->seed), value);                                \
+}                                                                                                                                   \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_GET(type)                                                                                                          \
+APOLLO_DEF FlatHashTable_Slot(type) *type##_flathashtable_getHashed(FlatHashTable(type) *table, const char *key, size_t len, uint64_t hash) { \
+  ptrdiff_t found = type##_flathashtable_find(table, key, len, hash);                                                                         \
+  return found < 0 ? NULL : &table->slots[found];                                                                                             \
+}                                                                                                                                             \
+APOLLO_DEF FlatHashTable_Slot(type) *type##_flathashtable_get(FlatHashTable(type) *table, char *key) {                                        \
+  size_t len = strlen(key);                                                                                                                   \
+  return type##_flathashtable_getHashed(table, key, len, table->hash(key, len, table->seed));                                                 \
+}                                                                                                                                             \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_DEL(type)                                                                                                         \
+APOLLO_DEF FlatHashTable_Slot(type) type##_flathashtable_delHashed(FlatHashTable(type) *table, const char *key, size_t len, uint64_t hash) { \
+  FlatHashTable_Slot(type) item = {0};                                                                                                       \
+  ptrdiff_t found = type##_flathashtable_find(table, key, len, hash);                                                                        \
+  if (found >= 0) {                                                                                                                          \
+    item = table->slots[found];                                                                                                              \
+    hashtable_setCtrl(table->ctrl, table->capacity, (size_t)found, HASHTABLE_CTRL_DELETED);                                                  \
+    table->count--;                                                                                                                          \
+  }                                                                                                                                          \
+  return item;                                                                                                                               \
+}                                                                                                                                            \
+APOLLO_DEF FlatHashTable_Slot(type) type##_flathashtable_del(FlatHashTable(type) *table, char *key) {                                        \
+  size_t len = strlen(key);                                                                                                                  \
+  return type##_flathashtable_delHashed(table, key, len, table->hash(key, len, table->seed));                                                \
+}                                                                                                                                            \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_VIEW(type)                                                                                    \
+APOLLO_DEF int type##_flathashtable_putView(FlatHashTable(type) *table, StrView key, type value) {                       \
+  return type##_flathashtable_putHashed(table, key.data, key.size, table->hash(key.data, key.size, table->seed), value); \
+}                                                                                                                        \
+APOLLO_DEF FlatHashTable_Slot(type) *type##_flathashtable_getView(FlatHashTable(type) *table, StrView key) {             \
+  return type##_flathashtable_getHashed(table, key.data, key.size, table->hash(key.data, key.size, table->seed));        \
+}                                                                                                                        \
+APOLLO_DEF FlatHashTable_Slot(type) type##_flathashtable_delView(FlatHashTable(type) *table, StrView key) {              \
+  return type##_flathashtable_delHashed(table, key.data, key.size, table->hash(key.data, key.size, table->seed));        \
+}                                                                                                                        \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define FLATHASHTABLE_IMPL_ITER(type)                                                                      \
+APOLLO_DEF FlatHashTable_Slot(type) *type##_flathashtable_next(FlatHashTable(type) *table, size_t *iter) { \
+  size_t idx = *iter;                                                                                      \
+  while (idx < table->capacity) {                                                                          \
+    uint32_t full = ~hashtable_groupFree(&table->ctrl[idx]) & 0xFFFF;                                      \
+    if (full == 0) {                                                                                       \
+      idx += HASHTABLE_GROUP;                                                                              \
+      continue;                                                                                            \
+    }                                                                                                      \
+    idx += hashtable_ctz(full);                                                                            \
+    if (idx >= table->capacity) break;                                                                     \
+    *iter = idx + 1;                                                                                       \
+    return &table->slots[idx];                                                                             \
+  }                                                                                                        \
+  *iter = table->capacity;                                                                                 \
+  return NULL;                                                                                             \
+}                                                                                                          \
+
+/////////////////////////////////////////
+//     INTEGER MAP / SET (INTERNAL)    //
+/////////////////////////////////////////
+
+/* The map and the set share these, a set simply has no values (NULL, size 0) */
+#define HASHTABLE_INT_USED(used, idx) (((used)[(idx) >> 6] >> ((idx) & 63)) & 1)
+#define HASHTABLE_INT_HOME(key, seed, mask) ((size_t)hashtable_mix((key) ^ (seed) ^ HASHTABLE_WY0, HASHTABLE_WY1) & (mask))
+
+/* Slot of (key) if present (returns true), else the empty slot ending its probe run */
+APOLLO_DEF bool hashtable_intFind(const uint64_t *keys, const uint64_t *used, size_t capacity, uint64_t seed, uint64_t key, size_t *idx) {
+  size_t mask = capacity - 1;
+  size_t i = HASHTABLE_INT_HOME(key, seed, mask);
+  while (HASHTABLE_INT_USED(used, i)) {
+    if (keys[i] == key) {
+      *idx = i;
+      return true;
+    }
+    i = (i + 1) & mask;
+  }
+  *idx = i;
+  return false;
+}
+
+/* Empties slot (idx) and shifts back the entries after it that would become unreachable */
+APOLLO_DEF void hashtable_intErase(uint64_t *keys, uint64_t *used, char *values, size_t valueSize, size_t capacity, uint64_t seed, size_t idx) {
+  size_t mask = capacity - 1;
+  size_t hole = idx;
+  for (size_t j = (idx + 1) & mask; HASHTABLE_INT_USED(used, j); j = (j + 1) & mask) {
+    size_t home = HASHTABLE_INT_HOME(keys[j], seed, mask);
+    if (((j - home) & mask) < ((j - hole) & mask)) continue;
+    keys[hole] = keys[j];
+    if (valueSize) memcpy(values + hole * valueSize, values + j * valueSize, valueSize);
+    hole = j;
+  }
+  used[hole >> 6] &= ~((uint64_t)1 << (hole & 63));
+}
+
+/* Moves the entries into a (capacity) block holding keys, values and the bitset */
+APOLLO_DEF int hashtable_intRehash(uint64_t **keys, uint64_t **used, char **values, size_t valueSize, size_t *capacity, uint64_t seed, size_t newCapacity) {
+  size_t words = (newCapacity + 63) / 64;
+  size_t valueBytes = (valueSize * newCapacity + 7) & ~(size_t)7;
+  uint64_t *nkeys = (uint64_t*) HASHTABLE_ALLOC(sizeof(uint64_t) * newCapacity + valueBytes + sizeof(uint64_t) * words);
+  if (nkeys == NULL) return 1;
+  char *nvalues = (char*)(nkeys + newCapacity);
+  uint64_t *nused = (uint64_t*)(nvalues + valueBytes);
+  memset(nused, 0, sizeof(uint64_t) * words);
+  for (size_t i=0; *keys != NULL && i<*capacity; i++) {
+    if (!HASHTABLE_INT_USED(*used, i)) continue;
+    size_t idx;
+    hashtable_intFind(nkeys, nused, newCapacity, seed, (*keys)[i], &idx);
+    nkeys[idx] = (*keys)[i];
+    if (valueSize) memcpy(nvalues + idx * valueSize, *values + i * valueSize, valueSize);
+    nused[idx >> 6] |= (uint64_t)1 << (idx & 63);
+  }
+  if (*keys != NULL) HASHTABLE_FREE(*keys);
+  *keys = nkeys;
+  *used = nused;
+  if (values != NULL) *values = nvalues;
+  *capacity = newCapacity;
+  return 0;
+}
+
+/* Slot at which (key) goes, growing first when the insert would pass 3/4 full, SIZE_MAX on malloc error */
+APOLLO_DEF size_t hashtable_intInsert(uint64_t **keys, uint64_t **used, char **values, size_t valueSize, size_t *capacity, size_t *count, uint64_t seed, uint64_t key, bool *found) {
+  size_t idx;
+  *found = hashtable_intFind(*keys, *used, *capacity, seed, key, &idx);
+  if (*found) return idx;
+  if ((*count + 1) * 4 > *capacity * 3) {
+    if (hashtable_intRehash(keys, used, values, valueSize, capacity, seed, *capacity * 2)) return SIZE_MAX;
+    hashtable_intFind(*keys, *used, *capacity, seed, key, &idx);
+  }
+  (*keys)[idx] = key;
+  (*used)[idx >> 6] |= (uint64_t)1 << (idx & 63);
+  (*count)++;
+  return idx;
+}
+
+/* Next used slot at or after (iter), SIZE_MAX at the end */
+APOLLO_DEF size_t hashtable_intNext(const uint64_t *used, size_t capacity, size_t iter) {
+  while (iter < capacity) {
+    uint64_t word = used[iter >> 6] >> (iter & 63);
+    if (word != 0) {
+#if defined(_MSC_VER)
+      unsigned long bit;
+      _BitScanForward64(&bit, word);
+      return iter + bit;
+#else
+      return iter + (size_t)__builtin_ctzll(word);
+#endif
+    }
+    iter = (iter | 63) + 1;
+  }
+  return SIZE_MAX;
+}
+
+APOLLO_DEF int intset_init(IntSet *set, size_t size) {
+  memset(set, 0, sizeof(IntSet));
+  size_t capacity = hashtable_roundPow2(size + size / 3 + 1);
+  return hashtable_intRehash(&set->keys, &set->used, NULL, 0, &set->capacity, set->seed, capacity < 64 ? 64 : capacity);
+}
+
+APOLLO_DEF void intset_free(IntSet *set) {
+  if (set->keys != NULL) HASHTABLE_FREE(set->keys);
+  memset(set, 0, sizeof(IntSet));
+}
+
+APOLLO_DEF int intset_add(IntSet *set, uint64_t key) {
+  bool found;
+  size_t idx = hashtable_intInsert(&set->keys, &set->used, NULL, 0, &set->capacity, &set->count, set->seed, key, &found);
+  return idx == SIZE_MAX;
+}
+
+APOLLO_DEF bool intset_has(IntSet *set, uint64_t key) {
+  size_t idx;
+  return hashtable_intFind(set->keys, set->used, set->capacity, set->seed, key, &idx);
+}
+
+APOLLO_DEF bool intset_del(IntSet *set, uint64_t key) {
+  size_t idx;
+  if (!hashtable_intFind(set->keys, set->used, set->capacity, set->seed, key, &idx)) return false;
+  hashtable_intErase(set->keys, set->used, NULL, 0, set->capacity, set->seed, idx);
+  set->count--;
+  return true;
+}
+
+APOLLO_DEF bool intset_next(IntSet *set, size_t *iter, uint64_t *key) {
+  size_t idx = hashtable_intNext(set->used, set->capacity, *iter);
+  if (idx == SIZE_MAX) {
+    *iter = set->capacity;
+    return false;
+  }
+  *key = set->keys[idx];
+  *iter = idx + 1;
+  return true;
+}
+
+#define INTMAP_IMPL(type) \
+INTMAP_IMPL_HT(type)      \
+INTMAP_IMPL_FUNCS(type)   \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define INTMAP_IMPL_HT(type)       \
+typedef struct s_##type##_intmap { \
+  uint64_t *keys;                  \
+  uint64_t *used;                  \
+  type *values;                    \
+  size_t capacity;                 \
+  size_t count;                    \
+  uint64_t seed;                   \
+} IntMap(type);                    \
+
+/* INTERNAL MACRO!!!!!, DO NOT USE */
+#define INTMAP_IMPL_FUNCS(type)                                                                              \
+APOLLO_DEF int type##_intmap_init(IntMap(type) *map, size_t size) {                                          \
+  memset(map, 0, sizeof(IntMap(type)));                                                                      \
+  size_t capacity = hashtable_roundPow2(size + size / 3 + 1);                                                \
+  char *values = NULL;                                                                                       \
+  int ret = hashtable_intRehash(&map->keys, &map->used, &values, sizeof(type),                               \
+    &map->capacity, map->seed, capacity < 64 ? 64 : capacity);                                               \
+  map->values = (type*)values;                                                                               \
+  return ret;                                                                                                \
+}                                                                                                            \
+APOLLO_DEF void type##_intmap_free(IntMap(type) *map) {                                                      \
+  if (map->keys != NULL) HASHTABLE_FREE(map->keys);                                                          \
+  memset(map, 0, sizeof(IntMap(type)));                                                                      \
+}                                                                                                            \
+APOLLO_DEF int type##_intmap_put(IntMap(type) *map, uint64_t key, type value) {                              \
+  bool found;                                                                                                \
+  char *values = (char*)map->values;                                                                         \
+  size_t idx = hashtable_intInsert(&map->keys, &map->used, &values, sizeof(type),                            \
+    &map->capacity, &map->count, map->seed, key, &found);                                                    \
+  map->values = (type*)values;                                                                               \
+  if (idx == SIZE_MAX) return 1;                                                                             \
+  map->values[idx] = value;                                                                                  \
+  return 0;                                                                                                  \
+}                                                                                                            \
+APOLLO_DEF type *type##_intmap_get(IntMap(type) *map, uint64_t key) {                                        \
+  size_t idx;                                                                                                \
+  if (!hashtable_intFind(map->keys, map->used, map->capacity, map->seed, key, &idx)) return NULL;            \
+  return &map->values[idx];                                                                                  \
+}                                                                                                            \
+APOLLO_DEF bool type##_intmap_del(IntMap(type) *map, uint64_t key) {                                         \
+  size_t idx;                                                                                                \
+  if (!hashtable_intFind(map->keys, map->used, map->capacity, map->seed, key, &idx)) return false;           \
+  hashtable_intErase(map->keys, map->used, (char*)map->values, sizeof(type), map->capacity, map->seed, idx); \
+  map->count--;                                                                                              \
+  return true;                                                                                               \
+}                                                                                                            \
+APOLLO_DEF type *type##_intmap_next(IntMap(type) *map, size_t *iter, uint64_t *key) {                        \
+  size_t idx = hashtable_intNext(map->used, map->capacity, *iter);                                           \
+  if (idx == SIZE_MAX) {                                                                                     \
+    *iter = map->capacity;                                                                                   \
+    return NULL;                                                                                             \
+  }                                                                                                          \
+  *key = map->keys[idx];                                                                                     \
+  *iter = idx + 1;                                                                                           \
+  return &map->values[idx];                                                                                  \
+}                                                                                                            \
+
+/////////////////////////////////////////
+//    SHARDED HASHTABLE (INTERNAL)     //
+/////////////////////////////////////////
+
+#if defined(_WIN32)
+#include <windows.h>
+#define HASHTABLE_RWLOCK SRWLOCK
+#define HASHTABLE_RWLOCK_INIT(lock) (InitializeSRWLock(lock), 0)
+#define HASHTABLE_RWLOCK_DESTROY(lock) ((void)(lock))
+#define HASHTABLE_RWLOCK_READ(lock) AcquireSRWLockShared(lock)
+#define HASHTABLE_RWLOCK_WRITE(lock) AcquireSRWLockExclusive(lock)
+#define HASHTABLE_RWLOCK_UNREAD(lock) ReleaseSRWLockShared(lock)
+#define HASHTABLE_RWLOCK_UNWRITE(lock) ReleaseSRWLockExclusive(lock)
+#else
+#include <pthread.h>
+#define HASHTABLE_RWLOCK pthread_rwlock_t
+#define HASHTABLE_RWLOCK_INIT(lock) pthread_rwlock_init(lock, NULL)
+#define HASHTABLE_RWLOCK_DESTROY(lock) pthread_rwlock_destroy(lock)
+#define HASHTABLE_RWLOCK_READ(lock) pthread_rwlock_rdlock(lock)
+#define HASHTABLE_RWLOCK_WRITE(lock) pthread_rwlock_wrlock(lock)
+#define HASHTABLE_RWLOCK_UNREAD(lock) pthread_rwlock_unlock(lock)
+#define HASHTABLE_RWLOCK_UNWRITE(lock) pthread_rwlock_unlock(lock)
+#endif
+
+/* Shard of (hash), the buckets inside a shard use the low bits so the shard takes the high ones */
+#define HASHTABLE_SHARD(table, hash) (&(table)->shards[((hash) >> 40) & ((table)->shardCount - 1)])
+
+#define SHARDEDHASHTABLE_IMPL(type) \
+SHARDEDHASHTABLE_IMPL_HT(type)      \
+SHARDEDHASHTABLE_IMPL_FREE(type)    \
+SHARDEDHASHTABLE_IMPL_INIT(type)    \
+SHARDEDHASHTABLE_IMPL_OPS(type)     \
 
 /* INTERNAL MACRO!!!!!, DO NOT USE */
-#define HASHTABLE_IMPL_FREE(type)                                   \
-APOLLO_DEF void type##_hashtable_free(HashTable(type) *table) {     \
-  for (int i=0; i<table->capacity; i++) {                           \
-    HashTable_KVP(type) *curr = table->items[i].next;               \
-    HashTable_KVP(type) *copy = curr;                               \
-    while (curr != NULL) {                                          \
-      curr = curr->next;          	                                \
-      HASHTABLE_FREE(copy);       	                                \
-      copy = curr;                	                                \
-    }                             	                                \
-  }                               	                                \
-  HASHTABLE_FREE(table->items);   	                                \
-}                                 	                                \
+#define SHARDEDHASHTABLE_IMPL_HT(type)   \
+typedef struct s_##type##_shard {        \
+  HASHTABLE_RWLOCK lock;                 \
+  HashTable(type) table;                 \
+  char pad[64];                          \
+} type##_ShardedHashTable_Shard;         \
+typedef struct s_##type##_sharded_ht {   \
+  HashFunctionEx hash;                   \
+  uint64_t seed;                         \
+  type##_ShardedHashTable_Shard *shards; \
+  size_t shardCount;                     \
+} ShardedHashTable(type);                \
 
 /* INTERNAL MACRO!!!!!, DO NOT USE */
-#define HASHTABLE_IMPL_PUT(type)                                                        \
-APOLLO_DEF int type##_hashtable_put(HashTable(type) *table, char *key, type value) {    \
-  int hash = table->hash(table->capacity, key);                                         \
-  if (!HASHTABLE_COLLIDES(type)(table, hash, key)) {                                    \
-    HashTable_KVP(type) *next = (table->items[hash].next);                              \
-    table->items[hash].key = key;                                                       \
-    table->items[hash].value = value;                                                   \
-    table->items[hash].next = next == NULL ? NULL : next;                               \
-  } else {                                                                              \
-    HashTable_KVP(type) *current = &(table->items[hash]);                               \
-    while (current->next != NULL) current = current->next;                              \
-    current->next = (HashTable_KVP(type)*)HASHTABLE_ALLOC(sizeof(HashTable_KVP(type))); \
-    if (current->next == NULL) return 1;                                                \
-    current->next->key = key;                                                           \
-    current->next->value = value;                                                       \
-    current->next->next = NULL;                                                         \
-  }                                                                                     \
-  return 0;                                                                             \
-}                                                                                       \
+#define SHARDEDHASHTABLE_IMPL_FREE(type)                                         \
+APOLLO_DEF void type##_shardedhashtable_free(ShardedHashTable(type) *table) {    \
+  for (size_t i=0; i<table->shardCount; i++) {                                   \
+    HASHTABLE_RWLOCK_DESTROY(&table->shards[i].lock);                            \
+    type##_hashtable_free(&table->shards[i].table);                              \
+  }                                                                              \
+  HASHTABLE_FREE(table->shards);                                                 \
+  table->shards = NULL;                                                          \
+  table->shardCount = 0;                                                         \
+}                                                                                \
+APOLLO_DEF size_t type##_shardedhashtable_count(ShardedHashTable(type) *table) { \
+  size_t count = 0;                                                              \
+  for (size_t i=0; i<table->shardCount; i++) {                                   \
+    HASHTABLE_RWLOCK_READ(&table->shards[i].lock);                               \
+    count += table->shards[i].table.count;                                       \
+    HASHTABLE_RWLOCK_UNREAD(&table->shards[i].lock);                             \
+  }                                                                              \
+  return count;                                                                  \
+}                                                                                \
 
 /* INTERNAL MACRO!!!!!, DO NOT USE */
-#define HASHTABLE_IMPL_GET(type)                                                        \
-APOLLO_DEF HashTable_KVP(type) type##_hashtable_get(HashTable(type) *table, char *key) {\
-  int hash = table->hash(table->capacity, key);                                         \
-  if (!HASHTABLE_COLLIDES(type)(table, hash, key)) {                                    \
-    return table->items[hash];                                                          \
-  } else {                                                                              \
-    HashTable_KVP(type) *current = &(table->items[hash]);                               \
-    while (strcmp(current->key, key) != 0 && current->next != NULL)                     \
-      current = current->next;                                                          \
-    return *current;                                                                    \
-  }                                                                                     \
-}                                                                                       \
+#define SHARDEDHASHTABLE_IMPL_INIT(type)                                                                                       \
+APOLLO_DEF int type##_shardedhashtable_init(ShardedHashTable(type) *table, size_t shards, size_t size, HashFunctionEx hash) {  \
+  table->shardCount = hashtable_roundPow2(shards);                                                                             \
+  table->hash = hash != NULL ? hash : HASHTABLE_HASH;                                                                          \
+  table->seed = 0;                                                                                                             \
+  table->shards = (type##_ShardedHashTable_Shard*) HASHTABLE_ALLOC(sizeof(type##_ShardedHashTable_Shard) * table->shardCount); \
+  if (table->shards == NULL) return 1;                                                                                         \
+  size_t perShard = size / table->shardCount;                                                                                  \
+  for (size_t i=0; i<table->shardCount; i++) {                                                                                 \
+    type##_ShardedHashTable_Shard *shard = &table->shards[i];                                                                  \
+    if (type##_hashtable_init(&shard->table, perShard ? perShard : 1, table->hash)) {                                          \
+      table->shardCount = i;                                                                                                   \
+      type##_shardedhashtable_free(table);                                                                                     \
+      return 1;                                                                                                                \
+    }                                                                                                                          \
+    if (HASHTABLE_RWLOCK_INIT(&shard->lock) != 0) {                                                                            \
+      type##_hashtable_free(&shard->table);                                                                                    \
+      table->shardCount = i;                                                                                                   \
+      type##_shardedhashtable_free(table);                                                                                     \
+      return 1;                                                                                                                \
+    }                                                                                                                          \
+  }                                                                                                                            \
+  return 0;                                                                                                                    \
+}                                                                                                                              \
 
 /* INTERNAL MACRO!!!!!, DO NOT USE */
-#define HASHTABLE_IMPL_DEL(type)                                                        \
-APOLLO_DEF HashTable_KVP(type) type##_hashtable_del(HashTable(type) *table, char *key) {\
-  int hash = table->hash(table->capacity, key);                                         \
-  HashTable_KVP(type) item = {0};                                                       \
-  if (!HASHTABLE_COLLIDES(type)(table, hash, key)) {                                    \
-    item = table->items[hash];                                                          \
-    if (table->items[hash].next == NULL) {                                              \
-      table->items[hash].key = NULL;                                                    \
-      table->items[hash].value = *(type*)&table->items[hash].next;                      \
-    } else {                                                                            \
-      HashTable_KVP(type) *collision = table->items[hash].next;                         \
-      table->items[hash].key = collision->key;                                          \
-      table->items[hash].value = collision->value;                                      \
-      table->items[hash].next = collision->next;                                        \
-      HASHTABLE_FREE(collision);                                                        \
-    }                                                                                   \
-  } else {                                                                              \
-    HashTable_KVP(type) *current = &(table->items[hash]);                               \
-    HashTable_KVP(type) *previous = NULL;                                               \
-    while (strcmp(current->key, key) != 0 && current->next != NULL) {                   \
-      previous = current;                                                               \
-      current = current->next;                                                          \
-    }                                                                                   \
-    if (current != NULL) {                                                              \
-      item = *current;                                                                  \
-      previous->next = current->next;                                                   \
-      HASHTABLE_FREE(current);                                                          \
-    }                                                                                   \
-  }                                                                                     \
-  return item;                                                                          \
-}                                                                                       \
+/* The key is hashed before taking the lock, the shard only runs the hashed operation */
+#define SHARDEDHASHTABLE_IMPL_OPS(type)                                                                                                       \
+APOLLO_DEF int type##_shardedhashtable_putHashed(ShardedHashTable(type) *table, const char *key, size_t len, uint64_t hash, type value) {     \
+  type##_ShardedHashTable_Shard *shard = HASHTABLE_SHARD(table, hash);                                                                        \
+  HASHTABLE_RWLOCK_WRITE(&shard->lock);                                                                                                       \
+  int ret = type##_hashtable_putHashed(&shard->table, key, len, hash, value);                                                                 \
+  HASHTABLE_RWLOCK_UNWRITE(&shard->lock);                                                                                                     \
+  return ret;                                                                                                                                 \
+}                                                                                                                                             \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_getHashed(ShardedHashTable(type) *table, const char *key, size_t len, uint64_t hash) { \
+  type##_ShardedHashTable_Shard *shard = HASHTABLE_SHARD(table, hash);                                                                        \
+  HASHTABLE_RWLOCK_READ(&shard->lock);                                                                                                        \
+  HashTable_KVP(type) item = type##_hashtable_getHashed(&shard->table, key, len, hash);                                                       \
+  HASHTABLE_RWLOCK_UNREAD(&shard->lock);                                                                                                      \
+  item.next = NULL;                                                                                                                           \
+  return item;                                                                                                                                \
+}                                                                                                                                             \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_delHashed(ShardedHashTable(type) *table, const char *key, size_t len, uint64_t hash) { \
+  type##_ShardedHashTable_Shard *shard = HASHTABLE_SHARD(table, hash);                                                                        \
+  HASHTABLE_RWLOCK_WRITE(&shard->lock);                                                                                                       \
+  HashTable_KVP(type) item = type##_hashtable_delHashed(&shard->table, key, len, hash);                                                       \
+  HASHTABLE_RWLOCK_UNWRITE(&shard->lock);                                                                                                     \
+  return item;                                                                                                                                \
+}                                                                                                                                             \
+APOLLO_DEF int type##_shardedhashtable_put(ShardedHashTable(type) *table, char *key, type value) {                                            \
+  size_t len = strlen(key);                                                                                                                   \
+  return type##_shardedhashtable_putHashed(table, key, len, table->hash(key, len, table->seed), value);                                       \
+}                                                                                                                                             \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_get(ShardedHashTable(type) *table, char *key) {                                        \
+  size_t len = strlen(key);                                                                                                                   \
+  return type##_shardedhashtable_getHashed(table, key, len, table->hash(key, len, table->seed));                                              \
+}                                                                                                                                             \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_del(ShardedHashTable(type) *table, char *key) {                                        \
+  size_t len = strlen(key);                                                                                                                   \
+  return type##_shardedhashtable_delHashed(table, key, len, table->hash(key, len, table->seed));                                              \
+}                                                                                                                                             \
+APOLLO_DEF int type##_shardedhashtable_putView(ShardedHashTable(type) *table, StrView key, type value) {                                      \
+  return type##_shardedhashtable_putHashed(table, key.data, key.size, table->hash(key.data, key.size, table->seed), value);                   \
+}                                                                                                                                             \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_getView(ShardedHashTable(type) *table, StrView key) {                                  \
+  return type##_shardedhashtable_getHashed(table, key.data, key.size, table->hash(key.data, key.size, table->seed));                          \
+}                                                                                                                                             \
+APOLLO_DEF HashTable_KVP(type) type##_shardedhashtable_delView(ShardedHashTable(type) *table, StrView key) {                                  \
+  return type##_shardedhashtable_delHashed(table, key.data, key.size, table->hash(key.data, key.size, table->seed));                          \
+}                                                                                                                                             \
 
 #endif
 #endif
\ No newline at end of file
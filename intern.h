@@ -0,0 +1,233 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+/*
+  STRING INTERNING POOL FOR APOLLO CODEBASE
+
+  % Every distinct byte string is stored once, its bytes are copied into a MemSeg (NUL terminated
+    so the canonical view also works as a C string) and never move while the memseg lives
+
+  % A string is known by a dense uint32_t id (0, 1, 2, ... in interning order) or by its canonical
+    StrView, two interned strings are equal exactly when their ids (or view pointers) are,
+    ids fit the integer maps of hashtable.h (IntMap(type) / IntSet) as keys directly
+
+  % The index is an open addressed table of (hash tag | id) words, the full hash of every id is
+    kept so growing never hashes a string again, lookups compare the tag before any byte
+
+  % Not thread safe, give each thread its own pool or guard it with a lock
+
+  % The translation unit also needs HASHTABLE_IMPLEMENTATION (for the hash functions) and
+    MEMSEG_IMPLEMENTATION
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "strview.h"
+#include "memseg.h"
+#include "hashtable.h"
+
+#ifdef APOLLO_DEF
+#undef APOLLO_DEF
+#endif
+#ifdef INTERN_IMPLEMENTATION
+#define APOLLO_DEF static
+#else
+#define APOLLO_DEF
+#endif
+
+/* Id returned when a string is not in the pool or could not be added */
+#define INTERN_NONE UINT32_MAX
+
+/* Hash function of the pool, same signature as HashFunctionEx */
+#ifndef INTERN_HASH
+#define INTERN_HASH HASHTABLE_HASH
+#endif
+
+/*
+  Struct describing a pool
+  @param memseg: memseg the bytes of the strings are copied into
+  @param strings: canonical view of every id
+  @param hashes: full hash of every id
+  @param slots: index, 0 when empty, else (high 32 bits of the hash) << 32 | (id + 1)
+  @param count: amount of strings
+  @param capacity: size of strings / hashes
+  @param slotCount: size of slots, a power of two
+  @param seed: passed to INTERN_HASH, set right after init for untrusted input (hashtable_randomSeed)
+*/
+typedef struct {
+  MemSeg *memseg;
+  StrView *strings;
+  uint64_t *hashes;
+  uint64_t *slots;
+  uint32_t count;
+  uint32_t capacity;
+  size_t slotCount;
+  uint64_t seed;
+} InternPool;
+
+/*
+  Initialize a pool
+  @param pool: stack address of the pool
+  @param memseg: memseg the strings are copied into, chained or virtual so it can grow
+  @param size: amount of strings expected, the index is sized for them up front
+  @returns 1 on malloc error, 0 on success
+*/
+APOLLO_DEF int intern_init(InternPool *pool, MemSeg *memseg, size_t size);
+
+/*
+  Deallocates the index of the pool, the bytes stay in the memseg (and go with it)
+  @param pool: stack address of the pool
+*/
+APOLLO_DEF void intern_free(InternPool *pool);
+
+/*
+  Interns a string, copying it only the first time it is seen
+  @param pool: stack address of the pool
+  @param str: bytes to intern, not referenced after the call
+  @returns id of the string, INTERN_NONE on malloc error / full memseg
+*/
+APOLLO_DEF uint32_t intern_id(InternPool *pool, StrView str);
+
+/*
+  Same as intern_id but returns the canonical view of the string
+  @returns canonical view, {NULL, 0} on malloc error / full memseg
+*/
+APOLLO_DEF StrView intern_view(InternPool *pool, StrView str);
+
+/*
+  Looks a string up without adding it
+  @param pool: stack address of the pool
+  @param str: bytes to look for
+  @returns id of the string, INTERN_NONE if it was never interned
+*/
+APOLLO_DEF uint32_t intern_find(InternPool *pool, StrView str);
+
+/*
+  Canonical view of an id
+  @param pool: stack address of the pool
+  @param id: id returned by intern_id / intern_find
+  @returns canonical view, {NULL, 0} for an unknown id
+*/
+APOLLO_DEF StrView intern_get(InternPool *pool, uint32_t id);
+
+#endif
+
+/////////////////////////////////////////
+//           IMPLEMENTATION            //
+/////////////////////////////////////////
+
+#if defined(INTERN_IMPLEMENTATION) && !defined(INTERN_IMPLEMENTED)
+#define INTERN_IMPLEMENTED
+
+#ifndef APOLLO_DEF
+#define APOLLO_DEF static
+#else
+#undef APOLLO_DEF
+#define APOLLO_DEF static
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Smallest index, it is kept at most 3/4 full */
+#define INTERN_MIN_SLOTS 64
+
+/* INTERNAL!!!, slot holding (str) or the empty slot it would go to */
+APOLLO_DEF size_t intern_slot(InternPool *pool, StrView str, uint64_t hash) {
+  size_t mask = pool->slotCount - 1, idx = hash & mask;
+  uint64_t tag = hash >> 32 << 32;
+  for (;; idx = (idx + 1) & mask) {
+    uint64_t slot = pool->slots[idx];
+    if (slot == 0) return idx;
+    if ((slot & 0xFFFFFFFF00000000ull) != tag) continue;
+
+    StrView known = pool->strings[(uint32_t)slot - 1];
+    if (known.size == str.size && memcmp(known.data, str.data, str.size) == 0) return idx;
+  }
+}
+
+/* INTERNAL!!!, rebuilds the index with (slotCount) slots from the cached hashes */
+APOLLO_DEF int intern_rehash(InternPool *pool, size_t slotCount) {
+  uint64_t *slots = (uint64_t*)calloc(slotCount, sizeof(uint64_t));
+  if (slots == NULL) return 1;
+
+  free(pool->slots);
+  pool->slots = slots;
+  pool->slotCount = slotCount;
+  for (uint32_t id=0; id<pool->count; id++) {
+    size_t idx = pool->hashes[id] & (slotCount - 1);
+    while (slots[idx] != 0) idx = (idx + 1) & (slotCount - 1);
+    slots[idx] = (pool->hashes[id] >> 32 << 32) | ((uint64_t)id + 1);
+  }
+  return 0;
+}
+
+APOLLO_DEF int intern_init(InternPool *pool, MemSeg *memseg, size_t size) {
+  memset(pool, 0, sizeof(InternPool));
+  pool->memseg = memseg;
+
+  size_t slotCount = INTERN_MIN_SLOTS;
+  while (slotCount / 4 * 3 < size) slotCount *= 2;
+  return intern_rehash(pool, slotCount);
+}
+
+APOLLO_DEF void intern_free(InternPool *pool) {
+  free(pool->strings);
+  free(pool->hashes);
+  free(pool->slots);
+  memset(pool, 0, sizeof(InternPool));
+}
+
+APOLLO_DEF uint32_t intern_find(InternPool *pool, StrView str) {
+  uint64_t hash = INTERN_HASH(str.data, str.size, pool->seed);
+  uint64_t slot = pool->slots[intern_slot(pool, str, hash)];
+  return slot == 0 ? INTERN_NONE : (uint32_t)slot - 1;
+}
+
+APOLLO_DEF uint32_t intern_id(InternPool *pool, StrView str) {
+  uint64_t hash = INTERN_HASH(str.data, str.size, pool->seed);
+  size_t idx = intern_slot(pool, str, hash);
+  if (pool->slots[idx] != 0) return (uint32_t)pool->slots[idx] - 1;
+  if (pool->count == INTERN_NONE - 1) return INTERN_NONE;
+
+  if (pool->count == pool->capacity) {
+    uint32_t capacity = pool->capacity == 0 ? INTERN_MIN_SLOTS : pool->capacity * 2;
+    StrView *strings = (StrView*)realloc(pool->strings, sizeof(StrView) * capacity);
+    if (strings == NULL) return INTERN_NONE;
+    pool->strings = strings;
+    uint64_t *hashes = (uint64_t*)realloc(pool->hashes, sizeof(uint64_t) * capacity);
+    if (hashes == NULL) return INTERN_NONE;
+    pool->hashes = hashes;
+    pool->capacity = capacity;
+  }
+
+  char *bytes = (char*)memseg_alloc(pool->memseg, str.size + 1);
+  if (bytes == NULL) return INTERN_NONE;
+  if (str.size > 0) memcpy(bytes, str.data, str.size);
+  bytes[str.size] = 0;
+
+  uint32_t id = pool->count++;
+  pool->strings[id] = (StrView){.data=bytes, .size=str.size};
+  pool->hashes[id] = hash;
+  if ((size_t)pool->count * 4 > pool->slotCount * 3) {
+    // the string is already listed, so the rebuilt index takes it in with the others
+    if (intern_rehash(pool, pool->slotCount * 2) == 0) return id;
+    pool->count--;
+    return INTERN_NONE;
+  }
+  pool->slots[idx] = (hash >> 32 << 32) | ((uint64_t)id + 1);
+  return id;
+}
+
+APOLLO_DEF StrView intern_view(InternPool *pool, StrView str) {
+  uint32_t id = intern_id(pool, str);
+  return id == INTERN_NONE ? (StrView){0} : pool->strings[id];
+}
+
+APOLLO_DEF StrView intern_get(InternPool *pool, uint32_t id) {
+  return id < pool->count ? pool->strings[id] : (StrView){0};
+}
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+/*
+  FIXED SIZE OBJECT POOL FOR APOLLO CODEBASE
+
+  % Hands out objects of one size from slabs, freed objects go to a free list
+    so both alloc and dealloc are O(1) and never touch malloc in steady state
+
+  % Slabs are malloc'd, or carved out of a MemSeg (then they live as long as the memseg)
+
+  % The pool is guarded by a spinlock, threads that churn objects should go through
+    a MemPool_Cache, which only touches the pool once every MEMPOOL_CACHE_BATCH objects
+
+  % Can back the chain nodes of hashtable.h:
+      #define HASHTABLE_NODE_ALLOC(size) mempool_alloc(&pool)
+      #define HASHTABLE_NODE_FREE(ptr) mempool_dealloc(&pool, ptr)
+*/
+
+#include "memseg.h"
+
+#ifdef APOLLO_DEF
+#undef APOLLO_DEF
+#endif
+#ifdef MEMPOOL_IMPLEMENTATION
+#define APOLLO_DEF static
+#else
+#define APOLLO_DEF
+#endif
+
+/* Objects moved between a MemPool_Cache and its pool at once */
+#ifndef MEMPOOL_CACHE_BATCH
+#define MEMPOOL_CACHE_BATCH 32
+#endif
+
+typedef struct s_mempool_node {
+  struct s_mempool_node *next;
+} MemPool_Node;
+
+/*
+  Struct describing a pool
+  @param free: list of released objects
+  @param slabs: list of malloc'd slabs, unused when carving from a memseg
+  @param memseg: memseg slabs are carved from, NULL to malloc them
+  @param bump: next never used object of the current slab
+  @param end: end of the current slab
+  @param size: size of an object, rounded up to pointer size
+  @param perSlab: amount of objects per slab
+  @param lock: spinlock guarding the pool
+*/
+typedef struct {
+  MemPool_Node *free;
+  MemPool_Node *slabs;
+  MemSeg *memseg;
+  char *bump;
+  char *end;
+  size_t size;
+  size_t perSlab;
+  volatile long lock;
+} MemPool;
+
+/*
+  Per thread front of a pool, keep one per thread (e.g. _Thread_local)
+  @param pool: pool the cache refills from / flushes to
+  @param free: list of cached objects
+  @param count: amount of cached objects
+*/
+typedef struct {
+  MemPool *pool;
+  MemPool_Node *free;
+  size_t count;
+} MemPool_Cache;
+
+/*
+  Initialize a pool whose slabs are malloc'd
+  @param pool: stack address of the pool
+  @param size: size of an object (e.g. sizeof(HashTable_KVP(type)))
+  @param perSlab: amount of objects allocated per slab
+*/
+APOLLO_DEF void mempool_init(MemPool *pool, size_t size, size_t perSlab);
+
+/*
+  Initialize a pool whose slabs are carved out of memseg
+  @param pool: stack address of the pool
+  @param size: size of an object
+  @param perSlab: amount of objects allocated per slab
+  @param memseg: memseg that provides (and owns) the slabs
+*/
+APOLLO_DEF void mempool_initMemSeg(MemPool *pool, size_t size, size_t perSlab, MemSeg *memseg);
+
+/*
+  Deallocates every malloc'd slab of the pool, objects become invalid
+  @param pool: stack address of the pool
+*/
+APOLLO_DEF void mempool_free(MemPool *pool);
+
+/*
+  Takes an object from the pool
+  @param pool: stack address of the pool
+  @returns pointer to an uninitialized object, NULL on malloc error / full memseg
+*/
+APOLLO_DEF void *mempool_alloc(MemPool *pool);
+
+/*
+  Returns an object to the pool
+  @param pool: stack address of the pool
+  @param ptr: object returned by mempool_alloc, NULL is ignored
+*/
+APOLLO_DEF void mempool_dealloc(MemPool *pool, void *ptr);
+
+/*
+  Per thread cache operations, same contract as mempool_alloc / mempool_dealloc
+  mempool_cacheFlush gives every cached object back to the pool, call before a thread exits
+*/
+APOLLO_DEF void mempool_cacheInit(MemPool_Cache *cache, MemPool *pool);
+APOLLO_DEF void *mempool_cacheAlloc(MemPool_Cache *cache);
+APOLLO_DEF void mempool_cacheDealloc(MemPool_Cache *cache, void *ptr);
+APOLLO_DEF void mempool_cacheFlush(MemPool_Cache *cache);
+
+#endif
+
+/////////////////////////////////////////
+//           IMPLEMENTATION            //
+/////////////////////////////////////////
+
+#ifdef MEMPOOL_IMPLEMENTATION
+
+#ifndef APOLLO_DEF
+#define APOLLO_DEF static
+#else
+#undef APOLLO_DEF
+#define APOLLO_DEF static
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MEMPOOL_LOCK(pool) while (_InterlockedExchange(&(pool)->lock, 1)) _mm_pause()
+#define MEMPOOL_UNLOCK(pool) _InterlockedExchange(&(pool)->lock, 0)
+#else
+#define MEMPOOL_LOCK(pool) while (__atomic_exchange_n(&(pool)->lock, 1, __ATOMIC_ACQUIRE))
+#define MEMPOOL_UNLOCK(pool) __atomic_store_n(&(pool)->lock, 0, __ATOMIC_RELEASE)
+#endif
+
+/* Slabs start 16 aligned and sizes are pointer multiples, so any type up to 16 alignment fits */
+#define MEMPOOL_SLAB_HEADER 16
+
+APOLLO_DEF void mempool_init(MemPool *pool, size_t size, size_t perSlab) {
+  memset(pool, 0, sizeof(MemPool));
+  if (size < sizeof(MemPool_Node)) size = sizeof(MemPool_Node);
+  pool->size = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+  pool->perSlab = perSlab == 0 ? 1 : perSlab;
+}
+
+APOLLO_DEF void mempool_initMemSeg(MemPool *pool, size_t size, size_t perSlab, MemSeg *memseg) {
+  mempool_init(pool, size, perSlab);
+  pool->memseg = memseg;
+}
+
+APOLLO_DEF void mempool_free(MemPool *pool) {
+  MemPool_Node *slab = pool->slabs;
+  while (slab != NULL) {
+    MemPool_Node *next = slab->next;
+    free(slab);
+    slab = next;
+  }
+
+  memset(pool, 0, sizeof(MemPool));
+}
+
+/* INTERNAL!!!, takes an object with the lock held */
+APOLLO_DEF void *mempool_take(MemPool *pool) {
+  if (pool->free != NULL) {
+    MemPool_Node *ret = pool->free;
+    pool->free = ret->next;
+    return ret;
+  }
+
+  if (pool->bump == pool->end) {
+    size_t bs = pool->size * pool->perSlab;
+    char *slab = NULL;
+    if (pool->memseg != NULL) {
+      slab = (char*)memseg_allocAligned(pool->memseg, bs, 16);
+      if (slab == NULL) return NULL;
+    } else {
+      MemPool_Node *header = (MemPool_Node*)malloc(MEMPOOL_SLAB_HEADER + bs);
+      if (header == NULL) return NULL;
+      header->next = pool->slabs;
+      pool->slabs = header;
+      slab = (char*)header + MEMPOOL_SLAB_HEADER;
+    }
+
+    pool->bump = slab;
+    pool->end = slab + bs;
+  }
+
+  void *ret = pool->bump;
+  pool->bump += pool->size;
+  return ret;
+}
+
+APOLLO_DEF void *mempool_alloc(MemPool *pool) {
+  MEMPOOL_LOCK(pool);
+  void *ret = mempool_take(pool);
+  MEMPOOL_UNLOCK(pool);
+  return ret;
+}
+
+APOLLO_DEF void mempool_dealloc(MemPool *pool, void *ptr) {
+  if (ptr == NULL) return;
+
+  MEMPOOL_LOCK(pool);
+  ((MemPool_Node*)ptr)->next = pool->free;
+  pool->free = (MemPool_Node*)ptr;
+  MEMPOOL_UNLOCK(pool);
+}
+
+APOLLO_DEF void mempool_cacheInit(MemPool_Cache *cache, MemPool *pool) {
+  cache->pool = pool;
+  cache->free = NULL;
+  cache->count = 0;
+}
+
+APOLLO_DEF void *mempool_cacheAlloc(MemPool_Cache *cache) {
+  if (cache->free == NULL) {
+    MEMPOOL_LOCK(cache->pool);
+    for (int i=0; i<MEMPOOL_CACHE_BATCH; i++) {
+      MemPool_Node *node = (MemPool_Node*)mempool_take(cache->pool);
+      if (node == NULL) break;
+      node->next = cache->free;
+      cache->free = node;
+      cache->count++;
+    }
+    MEMPOOL_UNLOCK(cache->pool);
+
+    if (cache->free == NULL) return NULL;
+  }
+
+  MemPool_Node *ret = cache->free;
+  cache->free = ret->next;
+  cache->count--;
+  return ret;
+}
+
+/* INTERNAL!!!, gives count objects of the cache back to its pool */
+APOLLO_DEF void mempool_cacheRelease(MemPool_Cache *cache, size_t count) {
+  if (count == 0) return;
+
+  MemPool_Node *first = cache->free;
+  MemPool_Node *last = first;
+  for (size_t i=1; i<count; i++) last = last->next;
+  cache->free = last->next;
+  cache->count -= count;
+
+  MEMPOOL_LOCK(cache->pool);
+  last->next = cache->pool->free;
+  cache->pool->free = first;
+  MEMPOOL_UNLOCK(cache->pool);
+}
+
+APOLLO_DEF void mempool_cacheDealloc(MemPool_Cache *cache, void *ptr) {
+  if (ptr == NULL) return;
+
+  ((MemPool_Node*)ptr)->next = cache->free;
+  cache->free = (MemPool_Node*)ptr;
+  cache->count++;
+
+  if (cache->count >= 2 * MEMPOOL_CACHE_BATCH) mempool_cacheRelease(cache, MEMPOOL_CACHE_BATCH);
+}
+
+APOLLO_DEF void mempool_cacheFlush(MemPool_Cache *cache) {
+  mempool_cacheRelease(cache, cache->count);
+}
+
+#endif
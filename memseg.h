@@ -1,23 +1,166 @@
 #ifndef MEMSEG_H
 #define MEMSEG_H
 
-#ifndef APOLLO_DEF
-#define APOLLO_DEF
-#else
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef APOLLO_DEF
 #undef APOLLO_DEF
+#endif
+#ifdef MEMSEG_IMPLEMENTATION
+#define APOLLO_DEF static
+#else
 #define APOLLO_DEF
 #endif
 
-#include <stdint.h>
-
 #define KB(x) (x*1024)
+#define MB(x) (KB(x)*1024)
+#define GB(x) ((size_t)MB(x)*1024)
+
+/*
+  Flags stored in MemSeg.flags
+  MEMSEG_CHAINED: memseg links in a new block when full instead of returning NULL
+  MEMSEG_VIRTUAL: memseg reserves address space up front and commits it as loc moves forward
+  MEMSEG_DECOMMIT: (virtual) rewinding / resetting gives the pages past loc back to the OS
+  MEMSEG_HUGEPAGES: (virtual) back the memseg with transparent huge pages when available
+*/
+#define MEMSEG_CHAINED (1 << 0)
+#define MEMSEG_VIRTUAL (1 << 1)
+#define MEMSEG_DECOMMIT (1 << 2)
+#define MEMSEG_HUGEPAGES (1 << 3)
 
+/* Granularity in which a virtual memseg commits memory */
+#ifndef MEMSEG_COMMIT_SIZE
+#define MEMSEG_COMMIT_SIZE KB(64)
+#endif
+#ifndef MEMSEG_HUGEPAGE_SIZE
+#define MEMSEG_HUGEPAGE_SIZE MB(2)
+#endif
+
+/*
+  Instrumentation, opt in by defining MEMSEG_STATS for the whole program (it changes MemSeg)
+  when not defined every hook compiles to nothing
+
+  % memseg_alloc / memseg_allocAligned / memseg_allocZero become macros recording their call site
+  % memseg_allocAtomic / memseg_allocLocal are not instrumented
+*/
+#ifdef MEMSEG_STATS
+
+#ifndef MEMSEG_STATS_SITES
+#define MEMSEG_STATS_SITES 64
+#endif
+#define MEMSEG_STATS_CLASSES 48
+
+/*
+  Allocations made from one call site
+  @param file: __FILE__ of the call, NULL for the slot collecting sites that didn't fit
+  @param line: __LINE__ of the call
+  @param count: amount of allocations
+  @param bytes: bytes requested
+*/
+typedef struct {
+  const char *file;
+  int line;
+  size_t count;
+  size_t bytes;
+} MemSeg_Site;
+
+/*
+  Counters of a memseg, see memseg_statsGet / memseg_statsDump
+  @param allocs: successful allocations
+  @param failed: allocations that returned NULL
+  @param requested: bytes requested by successful allocations
+  @param padded: bytes lost to alignment padding
+  @param used: bytes in use right now (requested + padded since the last rewind)
+  @param highWater: maximum value used has reached
+  @param classes: allocations per size class, class n holds sizes in [2^n, 2^(n+1))
+  @param sites: allocations per call site
+  @param file: (internal) call site of the allocation in progress
+  @param line: (internal) call site of the allocation in progress
+*/
 typedef struct {
+  size_t allocs;
+  size_t failed;
+  size_t requested;
+  size_t padded;
+  size_t used;
+  size_t highWater;
+  size_t classes[MEMSEG_STATS_CLASSES];
+  MemSeg_Site sites[MEMSEG_STATS_SITES];
+  const char *file;
+  int line;
+} MemSeg_Stats;
+
+#endif
+
+/*
+  Struct describing the current block of a memseg
+  @param base: start of the current block
+  @param max: size of the current block (virtual: committed bytes)
+  @param loc: used bytes of the current block
+  @param cap: (chained) maximum size for a new block, 0 for no limit
+              (virtual) reserved bytes
+  @param prev: (chained) header holding the previous block, NULL on the first block
+  @param spare: (chained) block kept by memseg_rewind for the next growth
+  @param flags: MEMSEG_* flags
+  @param stats: (MEMSEG_STATS) counters of the memseg
+*/
+typedef struct s_memseg {
   void *base;
   size_t max;
   size_t loc;
+  size_t cap;
+  struct s_memseg *prev;
+  struct s_memseg *spare;
+  uint8_t flags;
+#ifdef MEMSEG_STATS
+  MemSeg_Stats *stats;
+#endif
 } MemSeg;
 
+/*
+  Saved position of a memseg, see memseg_mark / memseg_rewind
+  @param prev: block the mark was taken in
+  @param loc: used bytes of that block
+*/
+typedef struct {
+  MemSeg *prev;
+  size_t loc;
+} MemSeg_Mark;
+
+/*
+  Scratch scope over a memseg, everything allocated inside it is released by memseg_tempEnd
+  @param memseg: memseg the scope allocates from
+  @param mark: position of the memseg when the scope began
+*/
+typedef struct {
+  MemSeg *memseg;
+  MemSeg_Mark mark;
+} MemSeg_Temp;
+
+/*
+  Per thread front of a memseg shared between threads, see memseg_allocLocal
+  @param memseg: shared memseg chunks are reserved from
+  @param bump: next free byte of the reserved chunk
+  @param end: end of the reserved chunk
+  @param chunk: amount of bytes reserved from memseg at once
+*/
+typedef struct {
+  MemSeg *memseg;
+  char *bump;
+  char *end;
+  size_t chunk;
+} MemSeg_Local;
+
+/* Amount and first block size of the per thread scratch memsegs */
+#ifndef MEMSEG_SCRATCH_COUNT
+#define MEMSEG_SCRATCH_COUNT 2
+#endif
+#ifndef MEMSEG_SCRATCH_SIZE
+#define MEMSEG_SCRATCH_SIZE KB(64)
+#endif
+
 /*
   Initialize and allocate memory for a stack managed memseg
   @param memseg: stack address of the memseg
@@ -26,7 +169,26 @@ typedef struct {
 APOLLO_DEF void memseg_init(MemSeg *memseg, size_t size);
 
 /*
-  Destroy and deallocate memory for a stack managed memseg
+  Initialize a chained memseg, when a block is full a new one is linked in
+  with double the size of the previous one (up to cap), old pointers stay valid
+  @param memseg: stack address of the memseg
+  @param size: size for the first block
+  @param cap: maximum size of a new block, 0 for no limit
+*/
+APOLLO_DEF void memseg_initChained(MemSeg *memseg, size_t size, size_t cap);
+
+/*
+  Initialize a virtual memseg, reserves address space for reserve bytes without backing it,
+  pages are committed in MEMSEG_COMMIT_SIZE chunks as the memseg is used, pointers never move
+  @param memseg: stack address of the memseg
+  @param reserve: maximum size the memseg can reach
+  @param flags: optional MEMSEG_DECOMMIT | MEMSEG_HUGEPAGES
+  @returns 0 on success, 1 when the address space couldn't be reserved
+*/
+APOLLO_DEF int memseg_initVirtual(MemSeg *memseg, size_t reserve, uint8_t flags);
+
+/*
+  Destroy and deallocate memory for a stack managed memseg (every block if chained)
   @param memseg: stack address of the memseg 
 */
 APOLLO_DEF void memseg_free(MemSeg *memseg);
@@ -35,8 +197,145 @@ APOLLO_DEF void memseg_free(MemSeg *memseg);
   Reserve a memory block in the memseg
   @param memseg: stack address of the memseg
   @param size: amount of memory to allocate
+  @returns pointer to the block, NULL when full and not chained (or out of memory)
+*/
+APOLLO_DEF void *(memseg_alloc)(MemSeg *memseg, size_t size);
+
+/*
+  Reserve a memory block in the memseg starting at an aligned address
+  @param memseg: stack address of the memseg
+  @param size: amount of memory to allocate
+  @param align: alignment of the block, must be a power of two
+  @returns pointer to the block, NULL when full and not chained (or out of memory)
 */
-APOLLO_DEF void *memseg_alloc(MemSeg *memseg, size_t size);
+APOLLO_DEF void *(memseg_allocAligned)(MemSeg *memseg, size_t size, size_t align);
+
+/*
+  Same as memseg_allocAligned but the block is zeroed
+*/
+APOLLO_DEF void *(memseg_allocZero)(MemSeg *memseg, size_t size, size_t align);
+
+/*
+  Reserve a memory block in a memseg shared between threads, lock free (compare-and-swap on loc,
+  a request that does not fit leaves loc as it was)
+  only the current block is used, a chained memseg won't grow and a virtual one won't commit,
+  so commit the range up front (memseg_alloc + memseg_reset) before sharing a virtual memseg
+  @param memseg: stack address of the memseg
+  @param size: amount of memory to allocate
+  @returns pointer to the block, NULL when full
+*/
+APOLLO_DEF void *memseg_allocAtomic(MemSeg *memseg, size_t size);
+
+/*
+  Initialize a per thread front of a shared memseg
+  @param local: stack address of the front, owned by a single thread
+  @param memseg: memseg shared between threads
+  @param chunk: amount of bytes reserved at once with memseg_allocAtomic
+*/
+APOLLO_DEF void memseg_localInit(MemSeg_Local *local, MemSeg *memseg, size_t chunk);
+
+/*
+  Reserve a memory block through a per thread front, the shared memseg is only touched
+  when the reserved chunk runs out
+  @param local: stack address of the front
+  @param size: amount of memory to allocate
+  @returns pointer to the block, NULL when the shared memseg is full
+*/
+APOLLO_DEF void *memseg_allocLocal(MemSeg_Local *local, size_t size);
+
+/*
+  Saves the current position of a memseg
+  @param memseg: stack address of the memseg
+  @returns mark to pass to memseg_rewind
+*/
+APOLLO_DEF MemSeg_Mark memseg_mark(MemSeg *memseg);
+
+/*
+  Releases everything allocated after mark was taken, blocks linked after it are dropped
+  @param memseg: stack address of the memseg
+  @param mark: value returned by memseg_mark on the same memseg
+*/
+APOLLO_DEF void memseg_rewind(MemSeg *memseg, MemSeg_Mark mark);
+
+/*
+  Releases everything allocated in the memseg, same as rewinding to its first byte
+  @param memseg: stack address of the memseg
+*/
+APOLLO_DEF void memseg_reset(MemSeg *memseg);
+
+/*
+  Begins / ends a scratch scope over a memseg, ending a scope with a NULL memseg does nothing
+*/
+APOLLO_DEF MemSeg_Temp memseg_tempBegin(MemSeg *memseg);
+APOLLO_DEF void memseg_tempEnd(MemSeg_Temp temp);
+
+/*
+  Begins a scratch scope on one of the calling thread's scratch memsegs
+  @param conflicts: memsegs in use by the caller (e.g. the one results go to), can be NULL
+  @param count: amount of conflicts
+  @returns scope over a scratch memseg not found in conflicts, release with memseg_releaseScratch,
+           its memseg is NULL when all MEMSEG_SCRATCH_COUNT scratch memsegs are in conflicts
+*/
+APOLLO_DEF MemSeg_Temp memseg_getScratch(MemSeg **conflicts, size_t count);
+#define memseg_releaseScratch(temp) memseg_tempEnd(temp)
+
+/*
+  Deallocates the calling thread's scratch memsegs, call before a thread exits
+*/
+APOLLO_DEF void memseg_freeScratch(void);
+
+#ifdef MEMSEG_STATS
+
+/*
+  Allocates like memseg_alloc (align 0), memseg_allocAligned or memseg_allocZero (zero 1)
+  recording the call site, used by the instrumented memseg_alloc* macros
+*/
+APOLLO_DEF void *memseg_allocSite(MemSeg *memseg, size_t size, size_t align, int zero, const char *file, int line);
+
+#define memseg_alloc(memseg, size) \
+  memseg_allocSite((memseg), (size), 0, 0, __FILE__, __LINE__)
+#define memseg_allocAligned(memseg, size, align) \
+  memseg_allocSite((memseg), (size), (align), 0, __FILE__, __LINE__)
+#define memseg_allocZero(memseg, size, align) \
+  memseg_allocSite((memseg), (size), (align), 1, __FILE__, __LINE__)
+
+/*
+  Copies the counters of a memseg
+  @param memseg: stack address of the memseg
+  @returns snapshot of the counters, zeroed if the memseg has none
+*/
+APOLLO_DEF MemSeg_Stats memseg_statsGet(MemSeg *memseg);
+
+/*
+  Clears the counters of a memseg (used / highWater restart at the bytes in use)
+  @param memseg: stack address of the memseg
+*/
+APOLLO_DEF void memseg_statsReset(MemSeg *memseg);
+
+/*
+  Prints the counters and the busiest call sites of a memseg
+  @param memseg: stack address of the memseg
+  @param out: stream to print to (e.g. stderr)
+*/
+APOLLO_DEF void memseg_statsDump(MemSeg *memseg, FILE *out);
+
+#endif
+
+/*
+  Typed helpers respecting the alignment of type
+  memseg_push(memseg, type) -> type* to one uninitialized type
+  memseg_pushZero(memseg, type) -> type* to one zeroed type
+  memseg_pushArray(memseg, type, n) -> type* to n uninitialized types
+  memseg_pushArrayZero(memseg, type, n) -> type* to n zeroed types
+*/
+#define memseg_push(memseg, type) \
+  ((type*)memseg_allocAligned((memseg), sizeof(type), _Alignof(type)))
+#define memseg_pushZero(memseg, type) \
+  ((type*)memseg_allocZero((memseg), sizeof(type), _Alignof(type)))
+#define memseg_pushArray(memseg, type, n) \
+  ((type*)memseg_allocAligned((memseg), sizeof(type)*(n), _Alignof(type)))
+#define memseg_pushArrayZero(memseg, type, n) \
+  ((type*)memseg_allocZero((memseg), sizeof(type)*(n), _Alignof(type)))
 
 #endif
 
@@ -44,7 +343,8 @@ APOLLO_DEF void *memseg_alloc(MemSeg *memseg, size_t size);
 //           IMPLEMENTATION            //
 /////////////////////////////////////////
 
-#ifdef MEMSEG_IMPLEMENTATION
+#if defined(MEMSEG_IMPLEMENTATION) && !defined(MEMSEG_IMPLEMENTED)
+#define MEMSEG_IMPLEMENTED
 
 #ifndef APOLLO_DEF
 #define APOLLO_DEF static
@@ -57,25 +357,428 @@ APOLLO_DEF void *memseg_alloc(MemSeg *memseg, size_t size);
 #include <stdlib.h>
 #include <stdio.h>
 
+#if defined(_MSC_VER)
+#define MEMSEG_THREAD_LOCAL __declspec(thread)
+#else
+#define MEMSEG_THREAD_LOCAL _Thread_local
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MEMSEG_LOAD(ptr) ((size_t)_InterlockedOr64((volatile __int64*)(ptr), 0))
+#define MEMSEG_CAS(ptr, expected, desired) \
+  ((size_t)_InterlockedCompareExchange64((volatile __int64*)(ptr), (__int64)(desired), (__int64)(expected)) == (expected))
+#else
+#define MEMSEG_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define MEMSEG_CAS(ptr, expected, desired) \
+  __atomic_compare_exchange_n((ptr), &(expected), (desired), 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#endif
+
+#ifdef MEMSEG_STATS
+
+/* INTERNAL!!!, bytes in use over every block */
+APOLLO_DEF size_t memseg_statsUsed(MemSeg *memseg) {
+  size_t used = memseg->loc;
+  for (MemSeg *header = memseg->prev; header != NULL; header = header->prev)
+    used += header->loc;
+  return used;
+}
+
+/* INTERNAL!!!, records a successful allocation */
+APOLLO_DEF void memseg_statsAlloc(MemSeg *memseg, size_t size, size_t pad) {
+  MemSeg_Stats *stats = memseg->stats;
+  if (stats == NULL) return;
+
+  stats->allocs++;
+  stats->requested += size;
+  stats->padded += pad;
+  stats->used += size + pad;
+  if (stats->used > stats->highWater) stats->highWater = stats->used;
+
+  int cls = 0;
+  while (cls < MEMSEG_STATS_CLASSES - 1 && (size >> (cls + 1)) != 0) cls++;
+  stats->classes[cls]++;
+
+  /* Open addressing on the call site, the last slot collects sites that didn't fit */
+  if (stats->file == NULL) return;
+  size_t slot = ((uint64_t)stats->file * 31 + stats->line) % (MEMSEG_STATS_SITES - 1);
+  for (int i=0; i<MEMSEG_STATS_SITES - 1; i++) {
+    MemSeg_Site *site = &stats->sites[(slot + i) % (MEMSEG_STATS_SITES - 1)];
+    if (site->file == NULL) {
+      site->file = stats->file;
+      site->line = stats->line;
+    }
+    if (site->file == stats->file && site->line == stats->line) {
+      site->count++;
+      site->bytes += size;
+      return;
+    }
+  }
+  stats->sites[MEMSEG_STATS_SITES - 1].count++;
+  stats->sites[MEMSEG_STATS_SITES - 1].bytes += size;
+}
+
+#define MEMSEG_STATS_INIT(memseg) ((memseg)->stats = (MemSeg_Stats*)calloc(1, sizeof(MemSeg_Stats)))
+#define MEMSEG_STATS_FREE(memseg) (free((memseg)->stats), (memseg)->stats = NULL)
+#define MEMSEG_STATS_ALLOC(memseg, size, pad) memseg_statsAlloc((memseg), (size), (pad))
+#define MEMSEG_STATS_FAIL(memseg) ((memseg)->stats != NULL ? (memseg)->stats->failed++ : 0)
+#define MEMSEG_STATS_REWIND(memseg) \
+  ((memseg)->stats != NULL ? (memseg)->stats->used = memseg_statsUsed(memseg) : 0)
+
+#else
+
+#define MEMSEG_STATS_INIT(memseg)
+#define MEMSEG_STATS_FREE(memseg)
+#define MEMSEG_STATS_ALLOC(memseg, size, pad)
+#define MEMSEG_STATS_FAIL(memseg)
+#define MEMSEG_STATS_REWIND(memseg)
+
+#endif
+
 APOLLO_DEF void memseg_init(MemSeg *memseg, size_t size) {
   memset(memseg, 0, sizeof(MemSeg));
   memseg->max = size;
   memseg->base = malloc(size);
+  MEMSEG_STATS_INIT(memseg);
+}
+
+APOLLO_DEF void memseg_initChained(MemSeg *memseg, size_t size, size_t cap) {
+  memseg_init(memseg, size);
+  memseg->cap = cap;
+  memseg->flags |= MEMSEG_CHAINED;
 }
 
+/* INTERNAL!!!, commit granularity of a virtual memseg */
+APOLLO_DEF size_t memseg_commitSize(MemSeg *memseg) {
+  return (memseg->flags & MEMSEG_HUGEPAGES) ? MEMSEG_HUGEPAGE_SIZE : MEMSEG_COMMIT_SIZE;
+}
+
+APOLLO_DEF int memseg_initVirtual(MemSeg *memseg, size_t reserve, uint8_t flags) {
+  memset(memseg, 0, sizeof(MemSeg));
+  memseg->flags = MEMSEG_VIRTUAL | (flags & (MEMSEG_DECOMMIT | MEMSEG_HUGEPAGES));
+
+  size_t chunk = memseg_commitSize(memseg);
+  reserve = (reserve + chunk - 1) & ~(chunk - 1);
+
+#if defined(_WIN32)
+  memseg->base = VirtualAlloc(NULL, reserve, MEM_RESERVE, PAGE_NOACCESS);
+  if (memseg->base == NULL) return 1;
+#else
+  /* Over reserve so the range can be aligned to the chunk size, needed for huge pages */
+  size_t extra = (flags & MEMSEG_HUGEPAGES) ? chunk : 0;
+  void *raw = mmap(NULL, reserve + extra, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (raw == MAP_FAILED) return 1;
+
+  uint64_t aligned = ((uint64_t)raw + extra) & ~(uint64_t)(extra ? extra - 1 : 0);
+  if (extra != 0) {
+    size_t head = aligned - (uint64_t)raw;
+    if (head != 0) munmap(raw, head);
+    if (extra - head != 0) munmap((void*)(aligned + reserve), extra - head);
+  }
+  memseg->base = (void*)aligned;
+
+#if defined(MADV_HUGEPAGE)
+  if (flags & MEMSEG_HUGEPAGES) madvise(memseg->base, reserve, MADV_HUGEPAGE);
+#endif
+#endif
+
+  memseg->cap = reserve;
+  MEMSEG_STATS_INIT(memseg);
+  return 0;
+}
+
+/* INTERNAL!!!, commits pages so that at least size bytes are usable, returns 0 when out of reserve */
+APOLLO_DEF int memseg_commit(MemSeg *memseg, size_t size) {
+  if (size > memseg->cap) return 0;
+
+  size_t chunk = memseg_commitSize(memseg);
+  size_t next = (size + chunk - 1) & ~(chunk - 1);
+  if (next > memseg->cap) next = memseg->cap;
+
+  void *from = (void*)((uint64_t)memseg->base + memseg->max);
+#if defined(_WIN32)
+  if (VirtualAlloc(from, next - memseg->max, MEM_COMMIT, PAGE_READWRITE) == NULL) return 0;
+#else
+  if (mprotect(from, next - memseg->max, PROT_READ | PROT_WRITE) != 0) return 0;
+#endif
+
+  memseg->max = next;
+  return 1;
+}
+
+/* INTERNAL!!!, gives back committed pages not needed to hold loc */
+APOLLO_DEF void memseg_decommit(MemSeg *memseg) {
+  size_t chunk = memseg_commitSize(memseg);
+  size_t keep = (memseg->loc + chunk - 1) & ~(chunk - 1);
+  if (keep == 0) keep = chunk;
+  if (keep >= memseg->max) return;
+
+  void *from = (void*)((uint64_t)memseg->base + keep);
+#if defined(_WIN32)
+  VirtualFree(from, memseg->max - keep, MEM_DECOMMIT);
+#else
+  madvise(from, memseg->max - keep, MADV_DONTNEED);
+  mprotect(from, memseg->max - keep, PROT_NONE);
+#endif
+
+  memseg->max = keep;
+}
+
+/* Blocks after the first one start with a header holding the previous block */
+#define MEMSEG_HEADER ((sizeof(MemSeg) + 15) & ~(size_t)15)
+
 APOLLO_DEF void memseg_free(MemSeg *memseg) {
-  free(memseg->base);
+  if (memseg->flags & MEMSEG_VIRTUAL) {
+#if defined(_WIN32)
+    VirtualFree(memseg->base, 0, MEM_RELEASE);
+#else
+    munmap(memseg->base, memseg->cap);
+#endif
+    MEMSEG_STATS_FREE(memseg);
+    return;
+  }
+
+  MemSeg block = *memseg;
+  while (block.prev != NULL) {
+    MemSeg *header = block.prev;
+    block = *header;
+    free(header);
+  }
+
+  free(block.base);
+  free(memseg->spare);
+  MEMSEG_STATS_FREE(memseg);
+}
+
+/* INTERNAL!!!, links a new block big enough for size, returns 0 on malloc error */
+APOLLO_DEF int memseg_grow(MemSeg *memseg, size_t size) {
+  size_t next = memseg->max * 2;
+  if (memseg->cap != 0 && next > memseg->cap) next = memseg->cap;
+  if (next < size) next = size;
+
+  MemSeg *header = NULL;
+  if (memseg->spare != NULL && memseg->spare->max >= size) {
+    header = memseg->spare;
+    next = header->max;
+    memseg->spare = NULL;
+  } else {
+    header = (MemSeg*)malloc(MEMSEG_HEADER + next);
+    if (header == NULL) return 0;
+  }
+
+  *header = *memseg;
+  header->spare = NULL;
+  memseg->prev = header;
+  memseg->base = (void*)((uint64_t)header + MEMSEG_HEADER);
+  memseg->max = next;
+  memseg->loc = 0;
+
+  return 1;
 }
 
-APOLLO_DEF void *memseg_alloc(MemSeg *memseg, size_t size) {
+APOLLO_DEF void *(memseg_alloc)(MemSeg *memseg, size_t size) {
   if (!(memseg->loc + size > memseg->max)) {
     void* ret = (void*)((uint64_t)memseg->base + memseg->loc);
     memseg->loc += size;
 
+    MEMSEG_STATS_ALLOC(memseg, size, 0);
     return ret;
   }
 
+  if ((memseg->flags & MEMSEG_CHAINED) && memseg_grow(memseg, size))
+    return (memseg_alloc)(memseg, size);
+
+  if ((memseg->flags & MEMSEG_VIRTUAL) && memseg_commit(memseg, memseg->loc + size))
+    return (memseg_alloc)(memseg, size);
+
+  MEMSEG_STATS_FAIL(memseg);
   return NULL;
 }
 
+APOLLO_DEF void *(memseg_allocAligned)(MemSeg *memseg, size_t size, size_t align) {
+  size_t pad = (size_t)(-((uint64_t)memseg->base + memseg->loc) & (align - 1));
+  if (!(memseg->loc + pad + size > memseg->max)) {
+    void* ret = (void*)((uint64_t)memseg->base + memseg->loc + pad);
+    memseg->loc += pad + size;
+
+    MEMSEG_STATS_ALLOC(memseg, size, pad);
+    return ret;
+  }
+
+  if ((memseg->flags & MEMSEG_CHAINED) && memseg_grow(memseg, size + align - 1))
+    return (memseg_allocAligned)(memseg, size, align);
+
+  if ((memseg->flags & MEMSEG_VIRTUAL) && memseg_commit(memseg, memseg->loc + pad + size))
+    return (memseg_allocAligned)(memseg, size, align);
+
+  MEMSEG_STATS_FAIL(memseg);
+  return NULL;
+}
+
+APOLLO_DEF void *(memseg_allocZero)(MemSeg *memseg, size_t size, size_t align) {
+  void *ret = (memseg_allocAligned)(memseg, size, align);
+  if (ret != NULL) memset(ret, 0, size);
+  return ret;
+}
+
+#ifdef MEMSEG_STATS
+
+APOLLO_DEF void *memseg_allocSite(MemSeg *memseg, size_t size, size_t align, int zero, const char *file, int line) {
+  if (memseg->stats != NULL) {
+    memseg->stats->file = file;
+    memseg->stats->line = line;
+  }
+
+  void *ret = NULL;
+  if (zero) ret = (memseg_allocZero)(memseg, size, align);
+  else if (align != 0) ret = (memseg_allocAligned)(memseg, size, align);
+  else ret = (memseg_alloc)(memseg, size);
+
+  if (memseg->stats != NULL) memseg->stats->file = NULL;
+  return ret;
+}
+
+APOLLO_DEF MemSeg_Stats memseg_statsGet(MemSeg *memseg) {
+  MemSeg_Stats ret = {0};
+  if (memseg->stats != NULL) ret = *memseg->stats;
+  return ret;
+}
+
+APOLLO_DEF void memseg_statsReset(MemSeg *memseg) {
+  if (memseg->stats == NULL) return;
+  memset(memseg->stats, 0, sizeof(MemSeg_Stats));
+  memseg->stats->used = memseg_statsUsed(memseg);
+  memseg->stats->highWater = memseg->stats->used;
+}
+
+APOLLO_DEF void memseg_statsDump(MemSeg *memseg, FILE *out) {
+  MemSeg_Stats stats = memseg_statsGet(memseg);
+  fprintf(out, "memseg %p: allocs=%zu failed=%zu requested=%zu padded=%zu used=%zu highWater=%zu\n",
+    (void*)memseg, stats.allocs, stats.failed, stats.requested, stats.padded, stats.used, stats.highWater);
+
+  for (int i=0; i<MEMSEG_STATS_CLASSES; i++) {
+    if (stats.classes[i] != 0)
+      fprintf(out, "  size [%llu, %llu): %zu\n", 1ull << i, 1ull << (i + 1), stats.classes[i]);
+  }
+
+  for (int i=0; i<MEMSEG_STATS_SITES; i++) {
+    MemSeg_Site *site = &stats.sites[i];
+    if (site->count == 0) continue;
+    if (site->file != NULL) fprintf(out, "  %s:%d: count=%zu bytes=%zu\n", site->file, site->line, site->count, site->bytes);
+    else fprintf(out, "  (other sites): count=%zu bytes=%zu\n", site->count, site->bytes);
+  }
+}
+
+#endif
+
+APOLLO_DEF MemSeg_Mark memseg_mark(MemSeg *memseg) {
+  return (MemSeg_Mark){.prev=memseg->prev, .loc=memseg->loc};
+}
+
+APOLLO_DEF void memseg_rewind(MemSeg *memseg, MemSeg_Mark mark) {
+  while (memseg->prev != mark.prev) {
+    MemSeg *header = memseg->prev;
+    size_t size = memseg->max;
+
+    memseg->base = header->base;
+    memseg->max = header->max;
+    memseg->loc = header->loc;
+    memseg->prev = header->prev;
+
+    /* Keep the biggest dropped block around so a rewind loop doesn't malloc / free */
+    if (memseg->spare == NULL || memseg->spare->max < size) {
+      free(memseg->spare);
+      header->max = size;
+      memseg->spare = header;
+    } else {
+      free(header);
+    }
+  }
+
+  memseg->loc = mark.loc;
+  MEMSEG_STATS_REWIND(memseg);
+
+  if ((memseg->flags & (MEMSEG_VIRTUAL | MEMSEG_DECOMMIT)) == (MEMSEG_VIRTUAL | MEMSEG_DECOMMIT))
+    memseg_decommit(memseg);
+}
+
+APOLLO_DEF void memseg_reset(MemSeg *memseg) {
+  memseg_rewind(memseg, (MemSeg_Mark){.prev=NULL, .loc=0});
+}
+
+APOLLO_DEF MemSeg_Temp memseg_tempBegin(MemSeg *memseg) {
+  return (MemSeg_Temp){.memseg=memseg, .mark=memseg_mark(memseg)};
+}
+
+APOLLO_DEF void memseg_tempEnd(MemSeg_Temp temp) {
+  if (temp.memseg == NULL) return;
+  memseg_rewind(temp.memseg, temp.mark);
+}
+
+static MEMSEG_THREAD_LOCAL MemSeg memseg_scratch[MEMSEG_SCRATCH_COUNT];
+
+APOLLO_DEF MemSeg_Temp memseg_getScratch(MemSeg **conflicts, size_t count) {
+  for (int i=0; i<MEMSEG_SCRATCH_COUNT; i++) {
+    MemSeg *scratch = &memseg_scratch[i];
+    int conflicting = 0;
+    for (size_t j=0; j<count; j++) {
+      if (conflicts[j] == scratch) conflicting = 1;
+    }
+    if (conflicting) continue;
+
+    if (scratch->base == NULL) memseg_initChained(scratch, MEMSEG_SCRATCH_SIZE, 0);
+    return memseg_tempBegin(scratch);
+  }
+
+  return (MemSeg_Temp){0};
+}
+
+APOLLO_DEF void memseg_freeScratch(void) {
+  for (int i=0; i<MEMSEG_SCRATCH_COUNT; i++) {
+    if (memseg_scratch[i].base != NULL) memseg_free(&memseg_scratch[i]);
+    memset(&memseg_scratch[i], 0, sizeof(MemSeg));
+  }
+}
+
+APOLLO_DEF void *memseg_allocAtomic(MemSeg *memseg, size_t size) {
+  size_t loc = MEMSEG_LOAD(&memseg->loc);
+  for (;;) {
+    if (loc > memseg->max || size > memseg->max - loc) return NULL;
+    if (MEMSEG_CAS(&memseg->loc, loc, loc + size)) break;
+    loc = MEMSEG_LOAD(&memseg->loc);
+  }
+
+  return (void*)((uint64_t)memseg->base + loc);
+}
+
+APOLLO_DEF void memseg_localInit(MemSeg_Local *local, MemSeg *memseg, size_t chunk) {
+  local->memseg = memseg;
+  local->bump = NULL;
+  local->end = NULL;
+  local->chunk = chunk;
+}
+
+APOLLO_DEF void *memseg_allocLocal(MemSeg_Local *local, size_t size) {
+  if (local->bump != NULL && (size_t)(local->end - local->bump) >= size) {
+    void *ret = local->bump;
+    local->bump += size;
+
+    return ret;
+  }
+
+  size_t reserve = size > local->chunk ? size : local->chunk;
+  char *chunk = (char*)memseg_allocAtomic(local->memseg, reserve);
+  if (chunk == NULL) return NULL;
+
+  local->bump = chunk + size;
+  local->end = chunk + reserve;
+  return chunk;
+}
+
 #endif
\ No newline at end of file
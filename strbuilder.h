@@ -0,0 +1,330 @@
+#ifndef STRBUILDER_H
+#define STRBUILDER_H
+
+/*
+  STRING BUILDER FOR APOLLO CODEBASE
+
+  % Appends StrViews, C strings, characters, integers and printf style pieces into one buffer
+    that is always NUL terminated, strbuilder_view hands it out as a StrView without a copy
+
+  % The buffer is one of:
+      malloc'd (strbuilder_init), doubled with realloc when full
+      carved from a MemSeg (strbuilder_initMemSeg), when the builder is the last allocation of
+        the memseg it grows in place, otherwise a block twice the size is taken and the old one
+        is left to the memseg
+      given by the caller (strbuilder_initBuffer), never grows, an append that does not fit is
+        truncated (like snprintf) and the builder is marked as overflowed
+
+  % Integers are written two digits at a time from a 200 byte table, straight into the buffer
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "strview.h"
+#include "memseg.h"
+
+#ifdef APOLLO_DEF
+#undef APOLLO_DEF
+#endif
+#ifdef STRBUILDER_IMPLEMENTATION
+#define APOLLO_DEF static
+#else
+#define APOLLO_DEF
+#endif
+
+/* Where the buffer of a builder comes from */
+#define STRBUILDER_MALLOC 0
+#define STRBUILDER_MEMSEG 1
+#define STRBUILDER_FIXED 2
+
+/*
+  Struct describing a builder
+  @param data: buffer, NUL terminated at data[size]
+  @param size: bytes appended
+  @param capacity: size of the buffer, one byte is always kept for the NUL
+  @param memseg: (STRBUILDER_MEMSEG) memseg the buffer is carved from
+  @param mode: STRBUILDER_MALLOC, STRBUILDER_MEMSEG or STRBUILDER_FIXED
+  @param overflow: an append was truncated (fixed buffer full, malloc / memseg failed)
+*/
+typedef struct {
+  char *data;
+  size_t size;
+  size_t capacity;
+  MemSeg *memseg;
+  uint8_t mode;
+  bool overflow;
+} StrBuilder;
+
+/*
+  Initialize a builder with a malloc'd buffer
+  @param sb: stack address of the builder
+  @param capacity: initial size of the buffer
+  @returns 1 on malloc error, 0 on success
+*/
+APOLLO_DEF int strbuilder_init(StrBuilder *sb, size_t capacity);
+
+/*
+  Initialize a builder carved from a memseg, it is released with the memseg
+  @param sb: stack address of the builder
+  @param memseg: memseg the buffer is allocated from
+  @param capacity: initial size of the buffer
+  @returns 1 when the memseg is full, 0 on success
+*/
+APOLLO_DEF int strbuilder_initMemSeg(StrBuilder *sb, MemSeg *memseg, size_t capacity);
+
+/*
+  Initialize a builder over caller memory (e.g. a stack array), it never grows
+  @param sb: stack address of the builder
+  @param buffer: memory to build in
+  @param capacity: size of buffer, at least 1
+*/
+APOLLO_DEF void strbuilder_initBuffer(StrBuilder *sb, char *buffer, size_t capacity);
+
+/*
+  Deallocates a malloc'd buffer, does nothing for the other modes
+  @param sb: stack address of the builder
+*/
+APOLLO_DEF void strbuilder_free(StrBuilder *sb);
+
+/*
+  Empties the builder keeping its buffer
+  @param sb: stack address of the builder
+*/
+APOLLO_DEF void strbuilder_reset(StrBuilder *sb);
+
+/*
+  Makes room for at least (extra) more bytes
+  @param sb: stack address of the builder
+  @param extra: bytes about to be appended
+  @returns false if the buffer could not grow that much
+*/
+APOLLO_DEF bool strbuilder_reserve(StrBuilder *sb, size_t extra);
+
+/*
+  Appends to the builder
+  @param sb: stack address of the builder
+  @returns false if the piece was truncated (a number that does not fit is left out whole),
+           see StrBuilder.overflow
+*/
+APOLLO_DEF bool strbuilder_append(StrBuilder *sb, StrView sv);
+APOLLO_DEF bool strbuilder_appendCStr(StrBuilder *sb, const char *cstr);
+APOLLO_DEF bool strbuilder_appendChar(StrBuilder *sb, char c);
+APOLLO_DEF bool strbuilder_appendU64(StrBuilder *sb, uint64_t value);
+APOLLO_DEF bool strbuilder_appendI64(StrBuilder *sb, int64_t value);
+
+/*
+  Appends a printf formatted piece, written straight into the buffer (grown first if needed)
+  @param sb: stack address of the builder
+  @param fmt: printf format
+  @returns false if the piece was truncated
+*/
+APOLLO_DEF bool strbuilder_appendf(StrBuilder *sb, const char *fmt, ...);
+
+/*
+  Contents of the builder, valid until the next append / reset / free
+  @param sb: stack address of the builder
+  @returns view of the contents, data is NUL terminated
+*/
+APOLLO_DEF StrView strbuilder_view(StrBuilder *sb);
+
+#endif
+
+/////////////////////////////////////////
+//           IMPLEMENTATION            //
+/////////////////////////////////////////
+
+#if defined(STRBUILDER_IMPLEMENTATION) && !defined(STRBUILDER_IMPLEMENTED)
+#define STRBUILDER_IMPLEMENTED
+
+#ifndef APOLLO_DEF
+#define APOLLO_DEF static
+#else
+#undef APOLLO_DEF
+#define APOLLO_DEF static
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+/* Smallest buffer a growing builder starts with */
+#define STRBUILDER_MIN_CAPACITY 64
+
+static const char strbuilder_digits[201] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+APOLLO_DEF int strbuilder_init(StrBuilder *sb, size_t capacity) {
+  memset(sb, 0, sizeof(StrBuilder));
+  sb->mode = STRBUILDER_MALLOC;
+  sb->capacity = capacity < STRBUILDER_MIN_CAPACITY ? STRBUILDER_MIN_CAPACITY : capacity;
+  sb->data = (char*)malloc(sb->capacity);
+  if (sb->data == NULL) {
+    sb->capacity = 0;
+    return 1;
+  }
+  sb->data[0] = 0;
+  return 0;
+}
+
+APOLLO_DEF int strbuilder_initMemSeg(StrBuilder *sb, MemSeg *memseg, size_t capacity) {
+  memset(sb, 0, sizeof(StrBuilder));
+  sb->mode = STRBUILDER_MEMSEG;
+  sb->memseg = memseg;
+  sb->capacity = capacity < STRBUILDER_MIN_CAPACITY ? STRBUILDER_MIN_CAPACITY : capacity;
+  sb->data = (char*)memseg_alloc(memseg, sb->capacity);
+  if (sb->data == NULL) {
+    sb->capacity = 0;
+    return 1;
+  }
+  sb->data[0] = 0;
+  return 0;
+}
+
+APOLLO_DEF void strbuilder_initBuffer(StrBuilder *sb, char *buffer, size_t capacity) {
+  memset(sb, 0, sizeof(StrBuilder));
+  sb->mode = STRBUILDER_FIXED;
+  sb->data = buffer;
+  sb->capacity = capacity;
+  if (capacity > 0) sb->data[0] = 0;
+}
+
+APOLLO_DEF void strbuilder_free(StrBuilder *sb) {
+  if (sb->mode == STRBUILDER_MALLOC) free(sb->data);
+  memset(sb, 0, sizeof(StrBuilder));
+}
+
+APOLLO_DEF void strbuilder_reset(StrBuilder *sb) {
+  sb->size = 0;
+  sb->overflow = false;
+  if (sb->capacity > 0) sb->data[0] = 0;
+}
+
+APOLLO_DEF bool strbuilder_reserve(StrBuilder *sb, size_t extra) {
+  if (sb->capacity > sb->size + extra) return true;
+  if (sb->mode == STRBUILDER_FIXED) return false;
+
+  size_t capacity = sb->capacity < STRBUILDER_MIN_CAPACITY ? STRBUILDER_MIN_CAPACITY : sb->capacity * 2;
+  while (capacity <= sb->size + extra) capacity *= 2;
+
+  if (sb->mode == STRBUILDER_MALLOC) {
+    char *data = (char*)realloc(sb->data, capacity);
+    if (data == NULL) return false;
+    sb->data = data;
+    sb->capacity = capacity;
+    return true;
+  }
+
+  // the buffer ends where the memseg does, so it can take the bytes right after it
+  MemSeg *memseg = sb->memseg;
+  size_t more = capacity - sb->capacity;
+  bool last = sb->data != NULL && (char*)memseg->base + memseg->loc == sb->data + sb->capacity;
+  if (last && (memseg->loc + more <= memseg->max || (memseg->flags & MEMSEG_VIRTUAL))) {
+    if (memseg_alloc(memseg, more) == NULL) return false;
+    sb->capacity = capacity;
+    return true;
+  }
+
+  char *data = (char*)memseg_alloc(memseg, capacity);
+  if (data == NULL) return false;
+  if (sb->data != NULL) memcpy(data, sb->data, sb->size + 1);
+  sb->data = data;
+  sb->capacity = capacity;
+  return true;
+}
+
+APOLLO_DEF bool strbuilder_append(StrBuilder *sb, StrView sv) {
+  bool ok = strbuilder_reserve(sb, sv.size);
+  size_t n = sv.size;
+  if (!ok) {
+    sb->overflow = true;
+    n = sb->capacity > sb->size + 1 ? sb->capacity - sb->size - 1 : 0;
+    if (n > sv.size) n = sv.size;
+  }
+
+  if (n > 0) memcpy(sb->data + sb->size, sv.data, n);
+  sb->size += n;
+  if (sb->capacity > 0) sb->data[sb->size] = 0;
+  return ok;
+}
+
+APOLLO_DEF bool strbuilder_appendCStr(StrBuilder *sb, const char *cstr) {
+  return strbuilder_append(sb, strview_fromParts((char*)cstr, strlen(cstr)));
+}
+
+APOLLO_DEF bool strbuilder_appendChar(StrBuilder *sb, char c) {
+  return strbuilder_append(sb, strview_fromParts(&c, 1));
+}
+
+APOLLO_DEF bool strbuilder_appendU64(StrBuilder *sb, uint64_t value) {
+  size_t digits = 1;
+  for (uint64_t rest = value; rest >= 10; rest /= 10) digits++;
+  if (!strbuilder_reserve(sb, digits)) {
+    sb->overflow = true;
+    return false;
+  }
+
+  // digits are written from the last one back, two per division
+  char *at = sb->data + sb->size + digits;
+  while (value >= 100) {
+    const char *pair = strbuilder_digits + (value % 100) * 2;
+    value /= 100;
+    *--at = pair[1];
+    *--at = pair[0];
+  }
+  if (value >= 10) {
+    *--at = strbuilder_digits[value * 2 + 1];
+    *--at = strbuilder_digits[value * 2];
+  } else {
+    *--at = (char)('0' + value);
+  }
+
+  sb->size += digits;
+  sb->data[sb->size] = 0;
+  return true;
+}
+
+APOLLO_DEF bool strbuilder_appendI64(StrBuilder *sb, int64_t value) {
+  if (value >= 0) return strbuilder_appendU64(sb, (uint64_t)value);
+
+  size_t size = sb->size;
+  if (strbuilder_appendChar(sb, '-') && strbuilder_appendU64(sb, 0 - (uint64_t)value)) return true;
+  // the sign alone would change the meaning of what follows, drop it too
+  sb->size = size;
+  if (sb->capacity > 0) sb->data[size] = 0;
+  return false;
+}
+
+APOLLO_DEF bool strbuilder_appendf(StrBuilder *sb, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  size_t room = sb->capacity > sb->size ? sb->capacity - sb->size : 0;
+  int n = vsnprintf(sb->data + sb->size, room, fmt, args);
+  va_end(args);
+  if (n < 0) return false;
+
+  if ((size_t)n >= room) {
+    if (!strbuilder_reserve(sb, (size_t)n)) {
+      // vsnprintf already wrote what fit
+      sb->overflow = true;
+      if (room > 0) sb->size = sb->capacity - 1;
+      return false;
+    }
+    va_start(args, fmt);
+    vsnprintf(sb->data + sb->size, sb->capacity - sb->size, fmt, args);
+    va_end(args);
+  }
+
+  sb->size += (size_t)n;
+  return true;
+}
+
+APOLLO_DEF StrView strbuilder_view(StrBuilder *sb) {
+  return strview_fromParts(sb->data, sb->size);
+}
+
+#endif
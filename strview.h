@@ -1,26 +1,67 @@
 #ifndef STRVIEW_H
 #define STRVIEW_H
 
-#ifndef APOLLO_DEF
-#define APOLLO_DEF
-#else
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Prototypes take the linkage of the definitions, static once STRVIEW_IMPLEMENTATION is defined */
+#ifdef APOLLO_DEF
 #undef APOLLO_DEF
+#endif
+#ifdef STRVIEW_IMPLEMENTATION
+#define APOLLO_DEF static
+#else
 #define APOLLO_DEF
 #endif
 
-#include <stdint.h>
-
 typedef struct {
   const char *data;
   size_t size;
 } StrView;
 
+/* Splits a view on every delim, the delimiters of 64 bytes are found at once and kept in mask */
+typedef struct {
+  StrView src;
+  size_t pos;
+  size_t block;
+  uint64_t mask;
+  char delim;
+  bool done;
+} StrViewSplit;
+
 APOLLO_DEF StrView strview_fromCStr(char *cstr);
 APOLLO_DEF StrView strview_fromParts(char *cstr, size_t amount);
 APOLLO_DEF StrView strview_chopByDelim(StrView src, char delim);
 APOLLO_DEF StrView strview_nextDelim(StrView src, char delim);
 APOLLO_DEF StrView strview_next(StrView sv);
 
+/* Search within sv.size bytes only, each returns the index of the match or sv.size if there is none */
+APOLLO_DEF size_t strview_findChar(StrView sv, char c);
+APOLLO_DEF size_t strview_findAny(StrView sv, StrView set);
+APOLLO_DEF size_t strview_findStr(StrView sv, StrView needle);
+
+/* Yields every field between delimiters, "a,,b," gives "a", "", "b" and "" */
+APOLLO_DEF StrViewSplit strview_split(StrView src, char delim);
+APOLLO_DEF bool strview_splitNext(StrViewSplit *split, StrView *field);
+
+/*
+  Number parsers reading the view in place, they stop at the first byte that does not belong to the
+  number and store how many bytes they used into (consumed) (may be NULL), returning one of:
+  STRVIEW_OK, STRVIEW_EMPTY when sv does not start with a number (nothing is consumed), or
+  STRVIEW_OVERFLOW when it does not fit (value saturates like strtoull / strtoll / strtod)
+  parseHex accepts an optional 0x prefix, parseI64 / parseDouble an optional sign, parseDouble
+  takes [+-]digits[.digits][e[+-]digits] with no inf / nan
+*/
+#define STRVIEW_OK 0
+#define STRVIEW_EMPTY 1
+#define STRVIEW_OVERFLOW 2
+
+APOLLO_DEF int strview_parseU64(StrView sv, uint64_t *value, size_t *consumed);
+APOLLO_DEF int strview_parseI64(StrView sv, int64_t *value, size_t *consumed);
+APOLLO_DEF int strview_parseHex(StrView sv, uint64_t *value, size_t *consumed);
+APOLLO_DEF int strview_parseDouble(StrView sv, double *value, size_t *consumed);
+
 APOLLO_DEF char strview_getc(StrView sv);
 
 APOLLO_DEF char *strview_toCStr(StrView sv);
@@ -29,7 +70,8 @@ APOLLO_DEF bool strview_intoBuff(StrView sv, char *buff, size_t buff_s);
 
 #endif
 
-#ifdef STRVIEW_IMPLEMENTATION
+#if defined(STRVIEW_IMPLEMENTATION) && !defined(STRVIEW_IMPLEMENTED)
+#define STRVIEW_IMPLEMENTED
 
 #ifndef APOLLO_DEF
 #define APOLLO_DEF static
@@ -40,6 +82,76 @@ APOLLO_DEF bool strview_intoBuff(StrView sv, char *buff, size_t buff_s);
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define STRVIEW_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STRVIEW_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+APOLLO_DEF unsigned strview_ctz(uint64_t x) {
+#if defined(_MSC_VER)
+  unsigned long ret;
+  _BitScanForward64(&ret, x);
+  return (unsigned)ret;
+#else
+  return (unsigned)__builtin_ctzll(x);
+#endif
+}
+
+/* Bitmask of the bytes among the 64 at p equal to any of the set */
+APOLLO_DEF uint64_t strview_mask64(const char *p, const char *set, size_t setSize) {
+#if defined(STRVIEW_AVX2)
+  __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+  __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+  __m256i eqLo = _mm256_setzero_si256(), eqHi = _mm256_setzero_si256();
+  for (size_t i=0; i<setSize; i++) {
+    __m256i c = _mm256_set1_epi8(set[i]);
+    eqLo = _mm256_or_si256(eqLo, _mm256_cmpeq_epi8(lo, c));
+    eqHi = _mm256_or_si256(eqHi, _mm256_cmpeq_epi8(hi, c));
+  }
+  return (uint64_t)(uint32_t)_mm256_movemask_epi8(eqHi) << 32 | (uint32_t)_mm256_movemask_epi8(eqLo);
+#elif defined(STRVIEW_SSE2)
+  uint64_t mask = 0;
+  for (int part=0; part<4; part++) {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)(p + part * 16));
+    __m128i eq = _mm_setzero_si128();
+    for (size_t i=0; i<setSize; i++) eq = _mm_or_si128(eq, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(set[i])));
+    mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(eq) << (part * 16);
+  }
+  return mask;
+#else
+  uint64_t mask = 0;
+  for (int i=0; i<64; i++) {
+    for (size_t j=0; j<setSize; j++) {
+      if (p[i] == set[j]) mask |= (uint64_t)1 << i;
+    }
+  }
+  return mask;
+#endif
+}
+
+/* Same as strview_mask64 for the block at (offset) of sv, which may be shorter than 64 bytes */
+APOLLO_DEF uint64_t strview_blockMask(StrView sv, size_t offset, const char *set, size_t setSize) {
+  if (sv.size - offset >= 64) return strview_mask64(sv.data + offset, set, setSize);
+  uint64_t mask = 0;
+  for (size_t i=offset; i<sv.size; i++) {
+    for (size_t j=0; j<setSize; j++) {
+      if (sv.data[i] == set[j]) mask |= (uint64_t)1 << (i - offset);
+    }
+  }
+  return mask;
+}
 
 APOLLO_DEF StrView strview_fromCStr(char *cstr) {
   StrView x = {.data=cstr, .size=strlen(cstr)};
@@ -52,25 +164,316 @@ APOLLO_DEF StrView strview_fromParts(char *cstr, size_t amount) {
 }
 
 APOLLO_DEF StrView strview_chopByDelim(StrView src, char delim) {
-  size_t c = 0;
-  while (c < src.size && src.data[c] != delim) c++;
-
-  StrView x = {.data=src.data, .size=c};
+  StrView x = {.data=src.data, .size=strview_findChar(src, delim)};
   return x;
 }
 
 APOLLO_DEF StrView strview_nextDelim(StrView src, char delim) {
-  char *next = strchr((char*)src.data, delim);
-  if (next == NULL) return src;
-  StrView x = {.data=next, .size=src.size - (next-src.data)};
+  size_t next = strview_findChar(src, delim);
+  if (next == src.size) return src;
+  StrView x = {.data=src.data + next, .size=src.size - next};
+  return x;
+}
+
+APOLLO_DEF size_t strview_findChar(StrView sv, char c) {
+#if defined(STRVIEW_SSE2)
+  size_t i = 0;
+  for (; i + 64 <= sv.size; i += 64) {
+    uint64_t mask = strview_mask64(sv.data + i, &c, 1);
+    if (mask != 0) return i + strview_ctz(mask);
+  }
+  __m128i needle = _mm_set1_epi8(c);
+  for (; i + 16 <= sv.size; i += 16) {
+    uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(sv.data + i)), needle));
+    if (mask != 0) return i + strview_ctz(mask);
+  }
+  for (; i < sv.size; i++) {
+    if (sv.data[i] == c) return i;
+  }
+  return sv.size;
+#else
+  const char *at = sv.size ? (const char*)memchr(sv.data, c, sv.size) : NULL;
+  return at == NULL ? sv.size : (size_t)(at - sv.data);
+#endif
+}
+
+APOLLO_DEF size_t strview_findAny(StrView sv, StrView set) {
+  if (set.size == 1) return strview_findChar(sv, set.data[0]);
+
+  size_t i = 0;
+  // every byte of the set costs one compare per vector, past a few a lookup table is cheaper
+  if (set.size <= 8) {
+    for (; i + 64 <= sv.size; i += 64) {
+      uint64_t mask = strview_mask64(sv.data + i, set.data, set.size);
+      if (mask != 0) return i + strview_ctz(mask);
+    }
+    uint64_t mask = strview_blockMask(sv, i, set.data, set.size);
+    return mask != 0 ? i + strview_ctz(mask) : sv.size;
+  }
+
+  bool table[256] = {0};
+  for (size_t j=0; j<set.size; j++) table[(uint8_t)set.data[j]] = true;
+  for (; i < sv.size; i++) {
+    if (table[(uint8_t)sv.data[i]]) return i;
+  }
+  return sv.size;
+}
+
+APOLLO_DEF size_t strview_findStr(StrView sv, StrView needle) {
+  if (needle.size == 0) return 0;
+  if (needle.size > sv.size) return sv.size;
+  if (needle.size == 1) return strview_findChar(sv, needle.data[0]);
+
+  // candidates match both the first and the last byte of needle, only those are compared
+  size_t last = sv.size - needle.size, i = 0;
+  char head = needle.data[0], tail = needle.data[needle.size - 1];
+#if defined(STRVIEW_AVX2)
+  __m256i first32 = _mm256_set1_epi8(head), last32 = _mm256_set1_epi8(tail);
+  for (; i + 32 <= last + 1; i += 32) {
+    __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(sv.data + i)), first32);
+    __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(sv.data + i + needle.size - 1)), last32);
+    for (uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(a, b)); mask != 0; mask &= mask - 1) {
+      size_t at = i + strview_ctz(mask);
+      if (memcmp(sv.data + at + 1, needle.data + 1, needle.size - 2) == 0) return at;
+    }
+  }
+#endif
+#if defined(STRVIEW_SSE2)
+  __m128i first16 = _mm_set1_epi8(head), last16 = _mm_set1_epi8(tail);
+  for (; i + 16 <= last + 1; i += 16) {
+    __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(sv.data + i)), first16);
+    __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(sv.data + i + needle.size - 1)), last16);
+    for (uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(a, b)); mask != 0; mask &= mask - 1) {
+      size_t at = i + strview_ctz(mask);
+      if (memcmp(sv.data + at + 1, needle.data + 1, needle.size - 2) == 0) return at;
+    }
+  }
+#endif
+  for (; i <= last; i++) {
+    if (sv.data[i] == head && sv.data[i + needle.size - 1] == tail &&
+        memcmp(sv.data + i + 1, needle.data + 1, needle.size - 2) == 0) return i;
+  }
+  return sv.size;
+}
+
+APOLLO_DEF StrViewSplit strview_split(StrView src, char delim) {
+  StrViewSplit x = {.src=src, .delim=delim};
+  x.mask = strview_blockMask(src, 0, &delim, 1);
   return x;
 }
 
+APOLLO_DEF bool strview_splitNext(StrViewSplit *split, StrView *field) {
+  if (split->done) return false;
+  while (split->mask == 0) {
+    split->block += 64;
+    if (split->block >= split->src.size) {
+      *field = (StrView){.data=split->src.data + split->pos, .size=split->src.size - split->pos};
+      split->done = true;
+      return true;
+    }
+    split->mask = strview_blockMask(split->src, split->block, &split->delim, 1);
+  }
+
+  size_t at = split->block + strview_ctz(split->mask);
+  split->mask &= split->mask - 1;
+  *field = (StrView){.data=split->src.data + split->pos, .size=at - split->pos};
+  split->pos = at + 1;
+  return true;
+}
+
 APOLLO_DEF StrView strview_next(StrView sv) {
   StrView x = {.data=sv.data+1, .size=sv.size-1};
   return x;
 }
 
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ || defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+#define STRVIEW_SWAR
+#endif
+
+#define STRVIEW_BYTES(x) (0x0101010101010101ull * (uint8_t)(x))
+
+/* Loads 8 bytes, the first one in the low byte */
+APOLLO_DEF uint64_t strview_load8(const char *p) {
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+/* True if the 8 bytes in v are all '0'..'9' */
+APOLLO_DEF bool strview_eightDigits(uint64_t v) {
+  return ((v & STRVIEW_BYTES(0xF0)) | (((v + STRVIEW_BYTES(0x06)) & STRVIEW_BYTES(0xF0)) >> 4)) == STRVIEW_BYTES(0x33);
+}
+
+/* Value of 8 decimal digits, three multiplies instead of eight */
+APOLLO_DEF uint32_t strview_eightValue(uint64_t v) {
+  v -= STRVIEW_BYTES('0');
+  v = (v * 10) + (v >> 8);
+  v = (((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+       (((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+  return (uint32_t)v;
+}
+
+/* Decimal digits at the start of sv into *value, counts leading zeros too, false on overflow */
+APOLLO_DEF bool strview_digits(StrView sv, uint64_t *value, size_t *count) {
+  uint64_t ret = 0;
+  size_t i = 0;
+#if defined(STRVIEW_SWAR)
+  // 19 digits always fit, 16 of them go 8 at a time
+  while (i + 8 <= sv.size && i + 8 <= 19 && strview_eightDigits(strview_load8(sv.data + i))) {
+    ret = ret * 100000000 + strview_eightValue(strview_load8(sv.data + i));
+    i += 8;
+  }
+#endif
+  bool ok = true;
+  for (; i < sv.size && (uint8_t)(sv.data[i] - '0') < 10; i++) {
+    uint64_t digit = (uint64_t)(sv.data[i] - '0');
+    if (ret > (UINT64_MAX - digit) / 10) ok = false;
+    ret = ok ? ret * 10 + digit : UINT64_MAX;
+  }
+  *value = ret;
+  *count = i;
+  return ok;
+}
+
+APOLLO_DEF int strview_parseU64(StrView sv, uint64_t *value, size_t *consumed) {
+  size_t count;
+  bool ok = strview_digits(sv, value, &count);
+  if (consumed != NULL) *consumed = count;
+  return count == 0 ? STRVIEW_EMPTY : ok ? STRVIEW_OK : STRVIEW_OVERFLOW;
+}
+
+APOLLO_DEF int strview_parseI64(StrView sv, int64_t *value, size_t *consumed) {
+  bool negative = sv.size > 0 && sv.data[0] == '-';
+  size_t sign = sv.size > 0 && (sv.data[0] == '-' || sv.data[0] == '+');
+  uint64_t magnitude, limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+  size_t count;
+  bool ok = strview_digits(strview_fromParts((char*)sv.data + sign, sv.size - sign), &magnitude, &count);
+  if (count == 0) {
+    *value = 0;
+    if (consumed != NULL) *consumed = 0;
+    return STRVIEW_EMPTY;
+  }
+
+  if (consumed != NULL) *consumed = sign + count;
+  if (!ok || magnitude > limit) {
+    *value = negative ? INT64_MIN : INT64_MAX;
+    return STRVIEW_OVERFLOW;
+  }
+  *value = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+  return STRVIEW_OK;
+}
+
+APOLLO_DEF bool strview_isHex(char c) {
+  return (uint8_t)(c - '0') < 10 || (uint8_t)((c | 0x20) - 'a') < 6;
+}
+
+/* True if the 8 bytes in v are all hex digits, checked as ranges on every byte at once */
+APOLLO_DEF bool strview_eightHex(uint64_t v) {
+  if (v & STRVIEW_BYTES(0x80)) return false;
+  uint64_t lower = v | STRVIEW_BYTES(0x20);
+  uint64_t digit = (v + STRVIEW_BYTES(0x80 - '0')) & ~(v + STRVIEW_BYTES(0x7F - '9'));
+  uint64_t letter = (lower + STRVIEW_BYTES(0x80 - 'a')) & ~(lower + STRVIEW_BYTES(0x7F - 'f'));
+  return ((digit | letter) & STRVIEW_BYTES(0x80)) == STRVIEW_BYTES(0x80);
+}
+
+/* Value of 8 hex digits, every nibble is computed in place then they are packed pairwise */
+APOLLO_DEF uint32_t strview_eightHexValue(uint64_t v) {
+  v = (v & STRVIEW_BYTES(0x0F)) + 9 * ((v >> 6) & STRVIEW_BYTES(0x01));
+  v = ((v << 4) | (v >> 8)) & 0x00FF00FF00FF00FFull;
+  v = ((v << 8) | (v >> 16)) & 0x0000FFFF0000FFFFull;
+  v = ((v << 16) | (v >> 32)) & 0x00000000FFFFFFFFull;
+  return (uint32_t)v;
+}
+
+APOLLO_DEF int strview_parseHex(StrView sv, uint64_t *value, size_t *consumed) {
+  size_t i = 0, prefix = 0;
+  if (sv.size > 2 && sv.data[0] == '0' && (sv.data[1] | 0x20) == 'x' && strview_isHex(sv.data[2])) prefix = i = 2;
+
+  uint64_t ret = 0;
+#if defined(STRVIEW_SWAR)
+  while (i + 8 <= sv.size && i - prefix + 8 <= 16 && strview_eightHex(strview_load8(sv.data + i))) {
+    ret = (ret << 32) | strview_eightHexValue(strview_load8(sv.data + i));
+    i += 8;
+  }
+#endif
+  bool ok = true;
+  for (; i < sv.size && strview_isHex(sv.data[i]); i++) {
+    uint8_t c = (uint8_t)sv.data[i];
+    if (ret >> 60) ok = false;
+    ret = ok ? (ret << 4) | (uint64_t)((c & 0xF) + 9 * (c >> 6)) : UINT64_MAX;
+  }
+
+  *value = ret;
+  if (consumed != NULL) *consumed = i;
+  return i == 0 ? STRVIEW_EMPTY : ok ? STRVIEW_OK : STRVIEW_OVERFLOW;
+}
+
+static const double strview_pow10[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+APOLLO_DEF int strview_parseDouble(StrView sv, double *value, size_t *consumed) {
+  size_t i = sv.size > 0 && (sv.data[0] == '-' || sv.data[0] == '+');
+  bool negative = i && sv.data[0] == '-';
+
+  // digits before and after the point make one integer, the point only moves the exponent
+  uint64_t mantissa = 0, fraction = 0;
+  size_t intDigits, fracDigits = 0;
+  bool exact = strview_digits(strview_fromParts((char*)sv.data + i, sv.size - i), &mantissa, &intDigits);
+  i += intDigits;
+  if (i < sv.size && sv.data[i] == '.') {
+    StrView rest = strview_fromParts((char*)sv.data + i + 1, sv.size - i - 1);
+    exact = strview_digits(rest, &fraction, &fracDigits) && exact;
+    if (intDigits + fracDigits > 0) i += 1 + fracDigits;
+  }
+  if (intDigits + fracDigits == 0) {
+    *value = 0;
+    if (consumed != NULL) *consumed = 0;
+    return STRVIEW_EMPTY;
+  }
+
+  int64_t exponent = 0;
+  if (i + 1 < sv.size && (sv.data[i] | 0x20) == 'e') {
+    int64_t e;
+    size_t used;
+    int err = strview_parseI64(strview_fromParts((char*)sv.data + i + 1, sv.size - i - 1), &e, &used);
+    if (err != STRVIEW_EMPTY) {
+      exponent = err == STRVIEW_OK && e > -100000 && e < 100000 ? e : (e < 0 ? -100000 : 100000);
+      i += 1 + used;
+    }
+  }
+  if (consumed != NULL) *consumed = i;
+
+  // exact when the digits fit the 53 bit mantissa and 10^exponent is itself exact
+  exponent -= (int64_t)fracDigits;
+  if (exact && intDigits + fracDigits <= 19) {
+    for (size_t d=0; d<fracDigits; d++) mantissa *= 10;
+    mantissa += fraction;
+    if (mantissa <= ((uint64_t)1 << 53) && exponent >= -22 && exponent <= 22) {
+      double ret = (double)mantissa;
+      ret = exponent < 0 ? ret / strview_pow10[-exponent] : ret * strview_pow10[exponent];
+      *value = negative ? -ret : ret;
+      return STRVIEW_OK;
+    }
+  }
+
+  // anything else is rounded by strtod from a stack copy of the first 100 significant digits
+  char copy[128];
+  size_t n = 0, start = sv.size > 0 && (sv.data[0] == '-' || sv.data[0] == '+');
+  if (negative) copy[n++] = '-';
+  for (size_t d=start; d<start + intDigits + fracDigits + (fracDigits > 0); d++) {
+    if (sv.data[d] == '.' || (sv.data[d] == '0' && n == (size_t)negative)) continue;
+    if (n < 101) copy[n++] = sv.data[d];
+    else exponent++;
+  }
+  // all digits were zeros, keep one so strtod still reads a number (and the sign of -0)
+  if (n == (size_t)negative) copy[n++] = '0';
+  snprintf(copy + n, sizeof(copy) - n, "e%lld", (long long)exponent);
+  *value = strtod(copy, NULL);
+  return *value == HUGE_VAL || *value == -HUGE_VAL ? STRVIEW_OVERFLOW : STRVIEW_OK;
+}
+
 APOLLO_DEF char strview_getc(StrView sv) {
   return *sv.data;
 }
@@ -84,9 +487,8 @@ APOLLO_DEF char *strview_toCStr(StrView sv) {
 }
 
 APOLLO_DEF uint64_t strview_toU64(StrView sv) {
-  char *x = strview_toCStr(sv);
-  uint64_t y = atoll(x);
-  free(x);
+  uint64_t y;
+  strview_parseU64(sv, &y, NULL);
   return y;
 }
 
@@ -0,0 +1,110 @@
+#define STRVIEW_IMPLEMENTATION
+#define MEMSEG_IMPLEMENTATION
+#define FSI_IMPLEMENTATION
+#define CSV_IMPLEMENTATION
+#include "../fsi.h"
+#include "../csv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ROWS 500000
+#define PARTS 4
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+  uint64_t sum[PARTS];
+  size_t escaped[PARTS];
+} totals;
+
+// second column is a number, the third a quoted comment
+void add(Csv_Record *record, unsigned part, void *user) {
+  totals *t = (totals*)user;
+  uint64_t value;
+  if (record->count > 1 && strview_parseU64(record->fields[1], &value, NULL) == STRVIEW_OK) t->sum[part] += value;
+  t->escaped[part] += record->escaped;
+}
+
+int main() {
+  char *sample = "id,amount,comment\r\n1,10,plain\r\n2,20,\"with, comma\"\r\n3,30,\"say \"\"hi\"\"\non two lines\"\r\n";
+  MemSeg memseg;
+  memseg_initChained(&memseg, KB(4), 0);
+
+  Csv_Parser parser;
+  Csv_Record record;
+  char unquoted[64];
+  csv_init(&parser, strview_fromCStr(sample), ',', &memseg);
+  while (csv_next(&parser, &record)) {
+    for (size_t i=0; i<record.count; i++) {
+      StrView field = record.fields[i];
+      if (record.escaped) field.size = csv_unquote(field, unquoted), field.data = unquoted;
+      printf("[%.*s]", (int)field.size, field.data);
+    }
+    printf(" %zu fields\n", record.count);
+  }
+
+  // a quote in the middle of a field is a plain byte, the parallel split must read it the same way
+  char *stray = "5\" disk,1\n\"multi\nline\",2\n3,3\n4,4\n";
+  size_t sequentialRecords = 0;
+  csv_init(&parser, strview_fromCStr(stray), ',', &memseg);
+  while (csv_next(&parser, &record)) sequentialRecords++;
+  MemSeg strayMemsegs[2];
+  for (int i=0; i<2; i++) memseg_initChained(&strayMemsegs[i], KB(4), 0);
+  totals ignored = {0};
+  size_t parallelRecords = csv_parseParallel(strview_fromCStr(stray), ',', 2, strayMemsegs, add, &ignored);
+  printf("stray quote: sequential %zu records, parallel %zu (%s)\n", sequentialRecords, parallelRecords,
+    sequentialRecords == parallelRecords ? "ok" : "MISMATCH");
+  for (int i=0; i<2; i++) memseg_free(&strayMemsegs[i]);
+
+  // a big file, read through a mapping so nothing is copied out of the page cache
+  FILE *out = fopen("csv_test.csv", "wb");
+  uint64_t expected = 0;
+  for (int i=0; i<ROWS; i++) {
+    expected += i % 1000;
+    if (i % 10 == 0) fprintf(out, "%d,%d,\"note, \"\"%d\"\"\nsecond line\",x\n", i, i % 1000, i);
+    else fprintf(out, "%d,%d,plain note %d,x\n", i, i % 1000, i);
+  }
+  fclose(out);
+
+  StrView file = fsi_mapFile(fsi_FileFromCstr("csv_test.csv"), FSI_ACCESS_SEQUENTIAL);
+
+  totals t = {0};
+  double start = now();
+  size_t records = 0;
+  csv_init(&parser, file, ',', &memseg);
+  MemSeg_Mark mark = memseg_mark(&memseg);
+  while (csv_next(&parser, &record)) {
+    add(&record, 0, &t);
+    memseg_rewind(&memseg, mark);
+    records++;
+  }
+  double sequential = now() - start;
+  printf("sequential: %zu records sum=%llu (%s) escaped=%zu %.1f ms\n", records, (unsigned long long)t.sum[0],
+    t.sum[0] == expected ? "ok" : "MISMATCH", t.escaped[0], sequential * 1e3);
+
+  MemSeg memsegs[PARTS];
+  for (int i=0; i<PARTS; i++) memseg_initChained(&memsegs[i], KB(4), 0);
+  memset(&t, 0, sizeof(t));
+  start = now();
+  records = csv_parseParallel(file, ',', PARTS, memsegs, add, &t);
+  double parallel = now() - start;
+
+  uint64_t sum = 0;
+  size_t escaped = 0;
+  for (int i=0; i<PARTS; i++) sum += t.sum[i], escaped += t.escaped[i];
+  printf("parallel (%d parts): %zu records sum=%llu (%s) escaped=%zu %.1f ms\n", PARTS, records,
+    (unsigned long long)sum, sum == expected ? "ok" : "MISMATCH", escaped, parallel * 1e3);
+
+  for (int i=0; i<PARTS; i++) memseg_free(&memsegs[i]);
+  memseg_free(&memseg);
+  fsi_unmapFile(file);
+  remove("csv_test.csv");
+  return 0;
+}
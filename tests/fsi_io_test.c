@@ -0,0 +1,150 @@
+#define STRVIEW_IMPLEMENTATION
+#define FSI_IMPLEMENTATION
+#include "../fsi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FILE_SIZE (64u << 20)
+#define BLOCK 4096
+#define READS 20000
+#define DEPTH 64
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// every 8 bytes hold their own offset, so any block can be checked on its own
+int check(const char *block, size_t offset) {
+  for (size_t i=0; i<BLOCK; i+=8) {
+    uint64_t value;
+    memcpy(&value, block + i, 8);
+    if (value != offset + i) return 0;
+  }
+  return 1;
+}
+
+size_t offsets[READS];
+
+void report(const char *name, double seconds, int bad) {
+  printf("%-16s %10.0f IOPS %s\n", name, READS / seconds, bad ? "MISMATCH" : "ok");
+}
+
+void engine(const char *name, fsi_File handle, uint8_t backend) {
+  fsi_IO io;
+  if (!fsi_ioInit(&io, DEPTH, backend)) {
+    printf("%-16s unavailable\n", name);
+    return;
+  }
+
+  char *buffers = (char*)malloc((size_t)BLOCK * DEPTH);
+  fsi_IORequest requests[DEPTH], *done[DEPTH], *idle[DEPTH];
+  for (int i=0; i<DEPTH; i++) idle[i] = &requests[i];
+  int idleCount = DEPTH, next = 0, finished = 0, bad = 0;
+
+  double start = now();
+  while (finished < READS) {
+    // refill every free slot, then submit them as one batch
+    while (idleCount > 0 && next < READS) {
+      fsi_IORequest *request = idle[--idleCount];
+      *request = (fsi_IORequest){.file=handle, .buffer=buffers + (request - requests) * BLOCK,
+        .size=BLOCK, .offset=offsets[next++], .op=FSI_IO_READ};
+      fsi_ioQueue(&io, request);
+    }
+    fsi_ioSubmit(&io);
+
+    unsigned count = fsi_ioComplete(&io, done, DEPTH, true);
+    for (unsigned i=0; i<count; i++) {
+      if (done[i]->result != BLOCK || !check((char*)done[i]->buffer, done[i]->offset)) bad = 1;
+      idle[idleCount++] = done[i];
+    }
+    finished += count;
+  }
+  report(name, now() - start, bad);
+
+  fsi_ioFree(&io);
+  free(buffers);
+}
+
+int main() {
+  fsi_File handle;
+  if (!fsi_FileOpen("fsi_io_test.bin", FSI_OPEN_WRITE, &handle)) return 1;
+
+  uint64_t *pattern = (uint64_t*)malloc(FILE_SIZE);
+  for (size_t i=0; i<FILE_SIZE/8; i++) pattern[i] = i * 8;
+  fsi_writeFile(handle, pattern, FILE_SIZE);
+  free(pattern);
+
+  uint32_t seed = 12345;
+  for (int i=0; i<READS; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    offsets[i] = (size_t)(seed % (FILE_SIZE / BLOCK)) * BLOCK;
+  }
+
+  // the old way, a path opens and closes the file for every read
+  fsi_File path = fsi_FileFromCstr("fsi_io_test.bin");
+  int bad = 0;
+  double start = now();
+  for (int i=0; i<READS; i++) {
+    size_t read;
+    char *block = fsi_readFileEx(path, fsi_Offset(offsets[i], offsets[i] + BLOCK), &read);
+    if (read != BLOCK || !check(block, offsets[i])) bad = 1;
+    free(block);
+  }
+  report("path readFileEx", now() - start, bad);
+
+  // one descriptor, one blocking pread per block
+  char block[BLOCK];
+  bad = 0;
+  start = now();
+  for (int i=0; i<READS; i++) {
+    if (fsi_readInto(handle, fsi_Offset(offsets[i], offsets[i] + BLOCK), block) != BLOCK) bad = 1;
+    else if (!check(block, offsets[i])) bad = 1;
+  }
+  report("handle readInto", now() - start, bad);
+
+  engine("io_uring", handle, FSI_IO_URING);
+  engine("thread pool", handle, FSI_IO_THREADS);
+  engine("sync batch", handle, FSI_IO_SYNC);
+
+  // writes go through the same engine, read back through the sync path
+  fsi_IO io;
+  if (fsi_ioInit(&io, 4, FSI_IO_AUTO)) {
+    fsi_IORequest write = {.file=handle, .buffer="ASYNC", .size=5, .offset=8, .op=FSI_IO_WRITE}, *done;
+    fsi_ioQueue(&io, &write);
+    fsi_ioSubmit(&io);
+    fsi_ioComplete(&io, &done, 1, true);
+    char back[6] = {0};
+    fsi_readInto(handle, fsi_Offset(8, 13), back);
+    printf("write: result=%zd back=%s backend=%d\n", (ssize_t)done->result, back, io.backend);
+    fsi_ioFree(&io);
+  }
+
+  // freeing an engine waits for what is in flight, queued requests that were never submitted are dropped
+  uint8_t backends[] = {FSI_IO_URING, FSI_IO_THREADS, FSI_IO_SYNC};
+  for (int b=0; b<3; b++) {
+    if (!fsi_ioInit(&io, 8, backends[b])) continue;
+    char blocks[4][BLOCK];
+    fsi_IORequest reads[4];
+    for (int i=0; i<4; i++) {
+      reads[i] = (fsi_IORequest){.file=handle, .buffer=blocks[i], .size=BLOCK, .offset=(size_t)i * BLOCK,
+        .op=FSI_IO_READ, .result=-1};
+    }
+    for (int i=0; i<3; i++) fsi_ioQueue(&io, &reads[i]);
+    unsigned submitted = fsi_ioSubmit(&io);
+    fsi_ioQueue(&io, &reads[3]);
+    fsi_IORequest huge = {.file=handle, .buffer=blocks[0], .size=(size_t)UINT32_MAX + 1, .op=FSI_IO_READ};
+    bool rejected = !fsi_ioQueue(&io, &huge);
+    fsi_ioFree(&io);
+    printf("free in flight (backend %d): submitted=%u results=%zd %zd %zd, huge rejected=%d\n", backends[b],
+      submitted, (ssize_t)reads[0].result, (ssize_t)reads[1].result, (ssize_t)reads[2].result, rejected);
+  }
+
+  fsi_FileClose(handle);
+  remove("fsi_io_test.bin");
+  return 0;
+}
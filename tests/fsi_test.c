@@ -1,3 +1,4 @@
+#define STRVIEW_IMPLEMENTATION
 #define FSI_IMPLEMENTATION
 #include "../fsi.h"
 
@@ -39,10 +40,81 @@ int main(int argc, char** argv) {
   );
 #endif
 
+  char *lines = "first line\nsecond line\nthird line\n";
+  fsi_File mapped = fsi_FileFromCstr("fsi_test3.txt");
+  fsi_writeFile(mapped, lines, strlen(lines));
+
+  StrView view = fsi_mapFile(mapped, FSI_ACCESS_SEQUENTIAL);
+  StrView first = strview_chopByDelim(view, '\n');
+  printf("mapped: size=%zu first=%.*s\n", view.size, (int)first.size, first.data);
+  fsi_unmapFile(view);
+
+  // one descriptor for every operation, each range read is a single pread
+  fsi_File handle;
+  if (fsi_FileOpen("fsi_test4.txt", FSI_OPEN_WRITE, &handle)) {
+    fsi_writeFile(handle, lines, strlen(lines));
+    fsi_writeFileEx(handle, 0, "FIRST", 5);
+
+    char range[8];
+    size_t total = 0, size = fsi_getFileSize(handle);
+    for (size_t at=0; at<size; at+=sizeof(range)) {
+      total += fsi_readInto(handle, fsi_Offset(at, at + sizeof(range)), range);
+    }
+    size_t read = 0;
+    char *whole = fsi_readFile(handle, &read);
+    printf("handle: size=%zu ranges=%zu read=%zu first=%.10s\n", size, total, read, whole);
+    free(whole);
+    fsi_FileClose(handle);
+  }
+
+  // a 16 byte buffer forces records across refills, only the cut record gets moved
+  fsi_Reader reader;
+  if (fsi_readerInit(&reader, fsi_FileFromCstr("fsi_test3.txt"), NULL, 16)) {
+    StrView record;
+    while (fsi_readerRecord(&reader, '\n', &record)) printf("record: %.*s\n", (int)record.size, record.data);
+    fsi_readerFree(&reader);
+  }
+
+  char chunkBuffer[16];
+  size_t streamed = 0, chunks = 0;
+  if (fsi_readerInit(&reader, fsi_FileFromCstr("fsi_test3.txt"), chunkBuffer, sizeof(chunkBuffer))) {
+    for (StrView chunk = fsi_readerNext(&reader); chunk.size != 0; chunk = fsi_readerNext(&reader), chunks++) {
+      streamed += chunk.size;
+    }
+    fsi_readerFree(&reader);
+  }
+  printf("streamed: %zu bytes in %zu chunks\n", streamed, chunks);
+
+  // 1000 small log records, written a buffer at a time and synced every 250 records
+  remove("fsi_test5.txt");
+  fsi_Writer writer;
+  char writeBuffer[4096], record[32];
+  if (fsi_writerInit(&writer, fsi_FileFromCstr("fsi_test5.txt"), writeBuffer, sizeof(writeBuffer), FSI_SYNC_GROUP, 250)) {
+    for (int i=0; i<1000; i++) {
+      int n = snprintf(record, sizeof(record), "record %d\n", i);
+      fsi_writerAppend(&writer, record, n);
+    }
+    fsi_writerFree(&writer);
+  }
+  size_t logged = 0;
+  if (fsi_readerInit(&reader, fsi_FileFromCstr("fsi_test5.txt"), chunkBuffer, sizeof(chunkBuffer))) {
+    StrView line;
+    while (fsi_readerRecord(&reader, '\n', &line)) logged++;
+    fsi_readerFree(&reader);
+  }
+  printf("appended: %zu records, %zu bytes\n", logged, fsi_getFileSize(fsi_FileFromCstr("fsi_test5.txt")));
+
+  // fsi_test2.txt only exists when the disabled tests above ran, nothing is read without it
   fsi_File file = fsi_FileFromCstr("fsi_test2.txt");
-  char* data = fsi_readFileEx(file, fsi_Offset(2, 5), NULL);
-  for (size_t x=0; x<strlen(data); x++) {
+  size_t read = 0;
+  char* data = fsi_readFileEx(file, fsi_Offset(2, 5), &read);
+  for (size_t x=0; x<read; x++) {
     printf("%x ", (uint8_t)data[x]);
   }
+  free(data);
+
+  remove("fsi_test3.txt");
+  remove("fsi_test4.txt");
+  remove("fsi_test5.txt");
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+#define MEMSEG_IMPLEMENTATION
+#include "../memseg.h"
+
+#define HASHTABLE_ARENA
+#define HASHTABLE_IMPLEMENTATION
+#include "../hashtable.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define ENTRIES 1000000
+
+HASHTABLE_IMPL(int);
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main() {
+  MemSeg arena;
+  memseg_initChained(&arena, MB(1), 0);
+
+  HashTable(int) table;
+  hashtable_initArena(int)(&table, 1024, NULL, &arena);
+
+  // one stack buffer for every key, the table keeps its own copies
+  char key[16];
+  for (int i=0; i<ENTRIES; i++) {
+    snprintf(key, sizeof(key), "key%d", i);
+    hashtable_put(int)(&table, key, i);
+  }
+  for (int i=0; i<ENTRIES; i+=4) {
+    snprintf(key, sizeof(key), "key%d", i);
+    hashtable_del(int)(&table, key);
+  }
+
+  int wrong = 0;
+  for (int i=0; i<ENTRIES; i++) {
+    snprintf(key, sizeof(key), "key%d", i);
+    HashTable_KVP(int) kvp = hashtable_get(int)(&table, key);
+    if ((i % 4 == 0) != (kvp.key == NULL) || (kvp.key != NULL && (kvp.value != i || kvp.key == key))) wrong++;
+  }
+  printf("arena: count=%zu capacity=%zu wrong=%d\n", table.count, table.capacity, wrong);
+
+  double begin = now();
+  hashtable_free(int)(&table);
+  memseg_free(&arena);
+  printf("arena release: %.3f ms\n", (now() - begin) * 1e3);
+
+  static char keys[ENTRIES][12];
+  HashTable(int) heap;
+  hashtable_init(int)(&heap, 1024, NULL);
+  for (int i=0; i<ENTRIES; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+    hashtable_put(int)(&heap, keys[i], i);
+  }
+
+  begin = now();
+  hashtable_free(int)(&heap);
+  printf("heap free: %.3f ms\n", (now() - begin) * 1e3);
+
+  return wrong != 0;
+}
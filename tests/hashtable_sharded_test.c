@@ -0,0 +1,116 @@
+#define HASHTABLE_IMPLEMENTATION
+#include "../hashtable.h"
+
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+
+#define MAX_THREADS 8
+#define KEYS_PER_THREAD 4096
+#define OPS_PER_THREAD 400000
+#define WRITE_PERCENT 10
+
+HASHTABLE_IMPL(int);
+SHARDEDHASHTABLE_IMPL(int);
+
+static char keys[MAX_THREADS * KEYS_PER_THREAD][12];
+
+typedef struct {
+  ShardedHashTable(int) *sharded;
+  HashTable(int) *global;
+  pthread_mutex_t *globalLock;
+  int id;
+  int threads;
+  int present[KEYS_PER_THREAD];
+} worker_args;
+
+// every thread reads any key but only writes its own, so its view of them can be checked at the end
+void *worker(void *data) {
+  worker_args *args = (worker_args*)data;
+  uint32_t seed = args->id * 2654435761u + 1;
+  char **own = (char**)malloc(sizeof(char*) * KEYS_PER_THREAD);
+  for (int i=0; i<KEYS_PER_THREAD; i++) own[i] = keys[args->id * KEYS_PER_THREAD + i];
+
+  for (int i=0; i<OPS_PER_THREAD; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    int write = (seed >> 8) % 100 < WRITE_PERCENT;
+    int k = (seed >> 12) % KEYS_PER_THREAD;
+    char *key = write ? own[k] : keys[((seed >> 4) % args->threads) * KEYS_PER_THREAD + k];
+
+    if (args->sharded != NULL) {
+      if (!write) shardedhashtable_get(int)(args->sharded, key);
+      else if (args->present[k]) shardedhashtable_del(int)(args->sharded, key);
+      else shardedhashtable_put(int)(args->sharded, key, args->id);
+    } else {
+      pthread_mutex_lock(args->globalLock);
+      if (!write) hashtable_get(int)(args->global, key);
+      else if (args->present[k]) hashtable_del(int)(args->global, key);
+      else hashtable_put(int)(args->global, key, args->id);
+      pthread_mutex_unlock(args->globalLock);
+    }
+    if (write) args->present[k] = !args->present[k];
+  }
+
+  free(own);
+  return NULL;
+}
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int run(int threads, int sharded) {
+  ShardedHashTable(int) table;
+  HashTable(int) global;
+  pthread_mutex_t globalLock = PTHREAD_MUTEX_INITIALIZER;
+  shardedhashtable_init(int)(&table, 64, MAX_THREADS * KEYS_PER_THREAD, NULL);
+  hashtable_init(int)(&global, MAX_THREADS * KEYS_PER_THREAD, NULL);
+
+  pthread_t handles[MAX_THREADS];
+  static worker_args args[MAX_THREADS];
+  for (int t=0; t<threads; t++) {
+    memset(&args[t], 0, sizeof(worker_args));
+    args[t].sharded = sharded ? &table : NULL;
+    args[t].global = &global;
+    args[t].globalLock = &globalLock;
+    args[t].id = t;
+    args[t].threads = threads;
+  }
+
+  double begin = now();
+  for (int t=0; t<threads; t++) pthread_create(&handles[t], NULL, worker, &args[t]);
+  for (int t=0; t<threads; t++) pthread_join(handles[t], NULL);
+  double elapsed = now() - begin;
+
+  int wrong = 0;
+  for (int t=0; t<threads; t++) {
+    for (int k=0; k<KEYS_PER_THREAD; k++) {
+      char *key = keys[t * KEYS_PER_THREAD + k];
+      HashTable_KVP(int) kvp = sharded ? shardedhashtable_get(int)(&table, key) : hashtable_get(int)(&global, key);
+      if ((kvp.key != NULL) != args[t].present[k] || (kvp.key != NULL && kvp.value != t)) wrong++;
+    }
+  }
+
+  printf("%-7s threads=%d  %6.2f Mops/s  keys=%zu wrong=%d\n", sharded ? "sharded" : "global", threads,
+    (double)threads * OPS_PER_THREAD / elapsed / 1e6,
+    sharded ? shardedhashtable_count(int)(&table) : global.count, wrong);
+
+  shardedhashtable_free(int)(&table);
+  hashtable_free(int)(&global);
+  return wrong;
+}
+
+int main() {
+  for (int i=0; i<MAX_THREADS * KEYS_PER_THREAD; i++) snprintf(keys[i], sizeof(keys[i]), "key%d", i);
+
+  printf("%d%% writes, %d ops per thread\n", WRITE_PERCENT, OPS_PER_THREAD);
+  int wrong = 0;
+  for (int threads=1; threads<=MAX_THREADS; threads*=2) {
+    wrong += run(threads, 0);
+    wrong += run(threads, 1);
+  }
+
+  return wrong != 0;
+}
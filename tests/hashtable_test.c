@@ -25,15 +25,27 @@ typedef struct {
 } sample_struct;
 
 HASHTABLE_IMPL(sample_struct);
+HASHTABLE_IMPL(int);
+FLATHASHTABLE_IMPL(int);
+INTMAP_IMPL(int);
 
-int djb2_hash(size_t cap, char *key) {
-  int hash = 5381;
-  while (*key != 0) {
-    hash = ((hash << 5) + hash) + (*key);
-    key++;
+uint64_t djb2_hash(const char *key, size_t len, uint64_t seed) {
+  uint64_t hash = 5381 + seed;
+  for (size_t i=0; i<len; i++) {
+    hash = ((hash << 5) + hash) + (uint8_t)key[i];
   }
 
-  return hash % cap;
+  return hash;
+}
+
+uint64_t fnv1a_hash(const char *key, size_t len, uint64_t seed) {
+  uint64_t hash = 14695981039346656037ull ^ seed;
+  for (size_t i=0; i<len; i++) {
+    hash ^= (uint8_t)key[i];
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
 }
 
 int main() {
@@ -44,12 +56,9 @@ int main() {
   hashtable_put(sample_struct)(&data, "foo", (sample_struct){NULL, 2});
   hashtable_put(sample_struct)(&data, "bar", (sample_struct){NULL, 3});
 
-  for (int i=0; i<data.capacity; i++) {
-    HashTable_KVP(sample_struct) *current = &(data.items[i]);
-    while (current != NULL) {
-      printf("%s -> %d\n", current->key, current->value.data);
-      current = current->next;
-    }
+  HashTable_Iter(sample_struct) it = hashtable_iter(sample_struct)(&data);
+  for (HashTable_KVP(sample_struct) *kvp; (kvp = hashtable_next(sample_struct)(&data, &it)) != NULL;) {
+    printf("%s -> %d\n", kvp->key, kvp->value.idx);
   }
 
   HashTable_KVP(sample_struct) foo = hashtable_get(sample_struct)(&data, "foo");
@@ -58,14 +67,123 @@ int main() {
   printf("%s -> %c\n", foo.key, foo.value.idx);
   printf("%s -> %c\n", bar.key, bar.value.idx);
 
-  for (int i=0; i<data.capacity; i++) {
-    HashTable_KVP(sample_struct) *current = &(data.items[i]);
-    while (current != NULL) {
-      printf("%s -> %d\n", current->key, current->value.data);
-      current = current->next;
-    }
+  it = hashtable_iter(sample_struct)(&data);
+  for (HashTable_KVP(sample_struct) *kvp; (kvp = hashtable_next(sample_struct)(&data, &it)) != NULL;) {
+    printf("%s -> %d\n", kvp->key, kvp->value.idx);
   }
 
   hashtable_free(sample_struct)(&data);
+
+  static char keys[1000][8];
+  for (int i=0; i<1000; i++) snprintf(keys[i], 8, "k%d", i);
+
+  HashTable(int) growing = {0};
+  hashtable_init(int)(&growing, 2, djb2_hash);
+  growing.rehashStep = 4;
+
+  for (int i=0; i<1000; i++) hashtable_put(int)(&growing, keys[i], i);
+  for (int i=0; i<1000; i+=2) hashtable_del(int)(&growing, keys[i]);
+
+  int wrong = 0;
+  for (int i=0; i<1000; i++) {
+    HashTable_KVP(int) kvp = hashtable_get(int)(&growing, keys[i]);
+    if ((i % 2 == 0) != (kvp.key == NULL) || (kvp.key != NULL && kvp.value != i)) wrong++;
+  }
+  printf("growing: count=%zu capacity=%zu resizing=%d wrong=%d\n",
+    growing.count, growing.capacity, growing.oldItems != NULL, wrong);
+
+  size_t visited = 0;
+  long sum = 0;
+  HashTable_Iter(int) iter = hashtable_iter(int)(&growing);
+  for (HashTable_KVP(int) *kvp; (kvp = hashtable_next(int)(&growing, &iter)) != NULL; visited++) sum += kvp->value;
+  printf("iter: visited=%zu sum=%ld\n", visited, sum);
+
+  // batched calls hash and prefetch HASHTABLE_BATCH keys before touching any bucket
+  char *batch[1000];
+  int values[1000];
+  for (int i=0; i<1000; i++) {
+    batch[i] = keys[i];
+    values[i] = -i;
+  }
+  HashTable(int) bulk = {0};
+  hashtable_init(int)(&bulk, 16, NULL);
+  hashtable_putMany(int)(&bulk, batch, values, 1000);
+
+  static HashTable_KVP(int) results[1000];
+  size_t found = hashtable_getMany(int)(&growing, batch, 1000, results);
+  printf("batch: bulk count=%zu capacity=%zu, found %zu of 1000 in growing, results[7]=%d\n",
+    bulk.count, bulk.capacity, found, results[7].value);
+
+  hashtable_free(int)(&bulk);
+
+  // keys need not be NUL terminated, "k13" is looked up through a view into a longer buffer
+  StrView view = {"k135", 3};
+  HashTable_KVP(int) viewed = hashtable_getView(int)(&growing, view);
+  printf("view: %.*s -> %d (len %zu, hash %llx)\n", (int)view.size, view.data, viewed.value,
+    viewed.keyLen, (unsigned long long)viewed.hash);
+
+  hashtable_free(int)(&growing);
+
+  // NULL picks the built in HASHTABLE_HASH, a random seed keeps untrusted keys from flooding one bucket
+  HashTable(int) seeded = {0};
+  hashtable_init(int)(&seeded, 100, NULL);
+  seeded.seed = hashtable_randomSeed();
+
+  for (int i=0; i<1000; i++) hashtable_put(int)(&seeded, keys[i], i);
+
+  size_t used = 0;
+  for (size_t i=0; i<seeded.capacity; i++) used += seeded.items[i].key != NULL;
+  printf("seeded: count=%zu capacity=%zu buckets used=%zu\n", seeded.count, seeded.capacity, used);
+  printf("wy(foo)=%016llx crc32(foo)=%016llx\n", (unsigned long long)hashtable_hashWy("foo", 3, 0),
+    (unsigned long long)hashtable_hashCrc32("foo", 3, 0));
+
+  hashtable_free(int)(&seeded);
+
+  FlatHashTable(int) flat = {0};
+  flathashtable_init(int)(&flat, 16, fnv1a_hash);
+
+  for (int i=0; i<1000; i++) flathashtable_put(int)(&flat, keys[i], i);
+
+  for (int i=0; i<1000; i+=2) flathashtable_del(int)(&flat, keys[i]);
+
+  int misses = 0;
+  for (int i=0; i<1000; i++) {
+    FlatHashTable_Slot(int) *slot = flathashtable_get(int)(&flat, keys[i]);
+    if ((i % 2 == 0) != (slot == NULL) || (slot != NULL && slot->value != i)) misses++;
+  }
+  printf("flat: count=%zu capacity=%zu misses=%d\n", flat.count, flat.capacity, misses);
+
+  size_t slot = 0, flatVisited = 0;
+  while (flathashtable_next(int)(&flat, &slot) != NULL) flatVisited++;
+  printf("flat iter: visited=%zu\n", flatVisited);
+
+  FlatHashTable_Slot(int) *flatView = flathashtable_getView(int)(&flat, view);
+  printf("flat view: %.*s -> %d\n", (int)view.size, view.data, flatView ? flatView->value : -1);
+
+  flathashtable_free(int)(&flat);
+
+  // integer keys stay inline, no string formatting or strcmp involved
+  IntMap(int) ids = {0};
+  intmap_init(int)(&ids, 16);
+  for (int i=0; i<1000; i++) intmap_put(int)(&ids, (uint64_t)i * 7919, i);
+  for (int i=0; i<1000; i+=2) intmap_del(int)(&ids, (uint64_t)i * 7919);
+
+  int idMisses = 0;
+  for (int i=0; i<1000; i++) {
+    int *value = intmap_get(int)(&ids, (uint64_t)i * 7919);
+    if ((i % 2 == 0) != (value == NULL) || (value != NULL && *value != i)) idMisses++;
+  }
+  printf("intmap: count=%zu capacity=%zu misses=%d bytes/slot=%.2f (chained KVP: %zu)\n",
+    ids.count, ids.capacity, idMisses, sizeof(uint64_t) + sizeof(int) + 1.0 / 8, sizeof(HashTable_KVP(int)));
+
+  intmap_free(int)(&ids);
+
+  IntSet seen;
+  intset_init(&seen, 0);
+  intset_add(&seen, 0);
+  intset_add(&seen, (uint64_t)(uintptr_t)&seen);
+  printf("intset: has 0=%d has &seen=%d has 1=%d count=%zu\n", intset_has(&seen, 0),
+    intset_has(&seen, (uint64_t)(uintptr_t)&seen), intset_has(&seen, 1), seen.count);
+  intset_free(&seen);
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#define STRVIEW_IMPLEMENTATION
+#define MEMSEG_IMPLEMENTATION
+#define HASHTABLE_IMPLEMENTATION
+#define INTERN_IMPLEMENTATION
+#include "../intern.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+INTMAP_IMPL(int);
+
+#define TOKENS 2000000
+#define DISTINCT 5000
+
+int main() {
+  MemSeg memseg;
+  memseg_initChained(&memseg, KB(16), 0);
+  InternPool pool;
+  intern_init(&pool, &memseg, 0);
+
+  // equal bytes from different buffers come back as one id and one canonical view
+  char first[] = "GET", second[] = "GET /index.html";
+  uint32_t a = intern_id(&pool, strview_fromCStr(first));
+  uint32_t b = intern_id(&pool, strview_fromParts(second, 3));
+  StrView va = intern_view(&pool, strview_fromCStr(first));
+  StrView vb = intern_get(&pool, b);
+  printf("ids: %u %u, same view: %d, as c string: %s\n", a, b, va.data == vb.data, vb.data);
+  printf("find POST: %s\n", intern_find(&pool, strview_fromCStr("POST")) == INTERN_NONE ? "none" : "found");
+
+  // a token stream with heavy repetition, counted through an IntMap keyed by id
+  char (*words)[16] = malloc(sizeof(*words) * DISTINCT);
+  for (int i=0; i<DISTINCT; i++) snprintf(words[i], sizeof(words[i]), "token_%d", i * 7919);
+
+  IntMap(int) counts;
+  intmap_init(int)(&counts, DISTINCT);
+  uint32_t seed = 1;
+  size_t bytes = 0;
+  clock_t start = clock();
+  for (int i=0; i<TOKENS; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    StrView word = strview_fromCStr(words[(seed >> 8) % DISTINCT]);
+    bytes += word.size;
+
+    uint32_t id = intern_id(&pool, word);
+    int *count = intmap_get(int)(&counts, id);
+    if (count != NULL) (*count)++;
+    else intmap_put(int)(&counts, id, 1);
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  size_t total = 0, wrong = 0, iter = 0;
+  uint64_t key;
+  int *count;
+  while ((count = intmap_next(int)(&counts, &iter, &key)) != NULL) {
+    total += *count;
+    StrView word = intern_get(&pool, (uint32_t)key);
+    if (intern_find(&pool, word) != key) wrong++;
+  }
+  printf("%d tokens (%zu bytes) -> %u strings, counted %zu, mismatched %zu, %.1f ms\n",
+    TOKENS, bytes, pool.count, total, wrong, seconds * 1e3);
+
+  intmap_free(int)(&counts);
+  intern_free(&pool);
+  memseg_free(&memseg);
+  free(words);
+  return 0;
+}
@@ -0,0 +1,69 @@
+#define MEMSEG_IMPLEMENTATION
+#include "../memseg.h"
+#define MEMPOOL_IMPLEMENTATION
+#include "../mempool.h"
+
+#include <stdio.h>
+
+MemPool node_pool;
+
+#define HASHTABLE_IMPLEMENTATION
+#include "../hashtable.h"
+#undef HASHTABLE_NODE_ALLOC
+#define HASHTABLE_NODE_ALLOC(size) mempool_alloc(&node_pool)
+#undef HASHTABLE_NODE_FREE
+#define HASHTABLE_NODE_FREE(ptr) mempool_dealloc(&node_pool, ptr)
+
+HASHTABLE_IMPL(int);
+
+uint64_t one_bucket(const char *key, size_t len, uint64_t seed) {
+  (void)key;
+  (void)len;
+  (void)seed;
+  return 0;
+}
+
+typedef struct {
+  int fd;
+  char addr[20];
+  double opened;
+} connection;
+
+int main() {
+  MemPool pool;
+  mempool_init(&pool, sizeof(connection), 4);
+
+  connection *conns[6];
+  for (int i=0; i<6; i++) {
+    conns[i] = (connection*)mempool_alloc(&pool);
+    conns[i]->fd = i;
+    printf("conn[%d] = %p\n", i, conns[i]);
+  }
+
+  mempool_dealloc(&pool, conns[2]);
+  connection *reused = (connection*)mempool_alloc(&pool);
+  printf("reused freed slot: %d\n", reused == conns[2]);
+
+  MemPool_Cache cache;
+  mempool_cacheInit(&cache, &pool);
+  for (int i=0; i<100; i++) mempool_cacheDealloc(&cache, mempool_cacheAlloc(&cache));
+  printf("cached: %zu\n", cache.count);
+  mempool_cacheFlush(&cache);
+  mempool_free(&pool);
+
+  MemSeg memseg;
+  memseg_initChained(&memseg, KB(4), 0);
+  mempool_initMemSeg(&node_pool, sizeof(HashTable_KVP(int)), 64, &memseg);
+
+  HashTable(int) table = {0};
+  hashtable_init(int)(&table, 1, one_bucket);
+  hashtable_put(int)(&table, "a", 1);
+  hashtable_put(int)(&table, "b", 2);
+  hashtable_put(int)(&table, "c", 3);
+  hashtable_del(int)(&table, "b");
+  printf("c -> %d, pool node at %p\n", hashtable_get(int)(&table, "c").value, table.items[0].next);
+  hashtable_free(int)(&table);
+
+  memseg_free(&memseg);
+  return 0;
+}
@@ -0,0 +1,119 @@
+#define MEMSEG_IMPLEMENTATION
+#include "../memseg.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#define MAX_THREADS 8
+#define ALLOCS_PER_THREAD 200000
+
+typedef struct {
+  MemSeg *shared;
+  int id;
+  int local;
+  void **ptrs;
+  size_t *sizes;
+} worker_args;
+
+typedef struct {
+  uint64_t begin;
+  uint64_t end;
+} range;
+
+void *worker(void *data) {
+  worker_args *args = (worker_args*)data;
+  MemSeg_Local local;
+  memseg_localInit(&local, args->shared, KB(16));
+
+  uint32_t seed = args->id * 2654435761u + 1;
+  for (int i=0; i<ALLOCS_PER_THREAD; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    size_t size = 1 + (seed >> 24) % 64;
+
+    void *ptr = args->local ? memseg_allocLocal(&local, size) : memseg_allocAtomic(args->shared, size);
+    if (ptr != NULL) memset(ptr, args->id, size);
+    args->ptrs[i] = ptr;
+    args->sizes[i] = size;
+  }
+
+  return NULL;
+}
+
+int compare_ranges(const void *a, const void *b) {
+  uint64_t x = ((range*)a)->begin, y = ((range*)b)->begin;
+  return x < y ? -1 : x > y;
+}
+
+double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int run(int threads, int local) {
+  MemSeg shared;
+  memseg_init(&shared, (size_t)threads * ALLOCS_PER_THREAD * 64 + threads * KB(16));
+
+  pthread_t handles[MAX_THREADS];
+  worker_args args[MAX_THREADS];
+  for (int t=0; t<threads; t++) {
+    args[t] = (worker_args){
+      .shared=&shared, .id=t+1, .local=local,
+      .ptrs=(void**)malloc(sizeof(void*) * ALLOCS_PER_THREAD),
+      .sizes=(size_t*)malloc(sizeof(size_t) * ALLOCS_PER_THREAD),
+    };
+  }
+
+  double begin = now();
+  for (int t=0; t<threads; t++) pthread_create(&handles[t], NULL, worker, &args[t]);
+  for (int t=0; t<threads; t++) pthread_join(handles[t], NULL);
+  double elapsed = now() - begin;
+
+  size_t total = (size_t)threads * ALLOCS_PER_THREAD;
+  range *ranges = (range*)malloc(sizeof(range) * total);
+  int failed = 0;
+  for (int t=0; t<threads; t++) {
+    for (int i=0; i<ALLOCS_PER_THREAD; i++) {
+      uint8_t *ptr = (uint8_t*)args[t].ptrs[i];
+      if (ptr == NULL) { failed = 1; continue; }
+      for (size_t j=0; j<args[t].sizes[i]; j++) {
+        if (ptr[j] != args[t].id) failed = 1;
+      }
+      ranges[t*ALLOCS_PER_THREAD + i] = (range){(uint64_t)ptr, (uint64_t)ptr + args[t].sizes[i]};
+    }
+    free(args[t].ptrs);
+    free(args[t].sizes);
+  }
+
+  qsort(ranges, total, sizeof(range), compare_ranges);
+  for (size_t i=1; i<total; i++) {
+    if (ranges[i].begin < ranges[i-1].end) failed = 1;
+  }
+
+  printf("%s threads=%d allocs/sec=%.0f %s\n",
+    local ? "local " : "atomic", threads, total / elapsed, failed ? "FAILED" : "ok");
+
+  free(ranges);
+  memseg_free(&shared);
+  return failed;
+}
+
+int main() {
+  int failed = 0;
+  for (int threads=1; threads<=MAX_THREADS; threads*=2) {
+    failed |= run(threads, 0);
+    failed |= run(threads, 1);
+  }
+
+  // a request that does not fit fails alone, the rest of the segment stays usable
+  MemSeg small;
+  memseg_init(&small, KB(4));
+  void *huge = memseg_allocAtomic(&small, KB(8));
+  void *fits = memseg_allocAtomic(&small, KB(2));
+  printf("oversized: %s, next fits: %s, loc=%zu\n", huge == NULL ? "NULL" : "FAILED",
+    fits != NULL ? "ok" : "FAILED", small.loc);
+  failed |= huge != NULL || fits == NULL;
+  memseg_free(&small);
+
+  return failed;
+}
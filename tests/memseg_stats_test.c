@@ -0,0 +1,36 @@
+#define MEMSEG_STATS
+#define MEMSEG_IMPLEMENTATION
+#include "../memseg.h"
+
+typedef struct {
+  double x, y, z;
+} vec3;
+
+int main() {
+  MemSeg main;
+  memseg_initChained(&main, KB(1), 0);
+
+  for (int i=0; i<100; i++) {
+    memseg_alloc(&main, 3);
+    memseg_push(&main, vec3);
+  }
+
+  MemSeg_Mark mark = memseg_mark(&main);
+  memseg_pushArrayZero(&main, uint64_t, 4096);
+  memseg_rewind(&main, mark);
+
+  MemSeg fixed;
+  memseg_init(&fixed, 16);
+  memseg_alloc(&fixed, 32);
+
+  MemSeg_Stats stats = memseg_statsGet(&main);
+  printf("allocs=%zu padded=%zu used=%zu highWater=%zu\n",
+    stats.allocs, stats.padded, stats.used, stats.highWater);
+  printf("fixed failed=%zu\n", memseg_statsGet(&fixed).failed);
+
+  memseg_statsDump(&main, stdout);
+
+  memseg_free(&fixed);
+  memseg_free(&main);
+  return 0;
+}
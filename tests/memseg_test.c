@@ -31,4 +31,53 @@ int main() {
   }
   
   memseg_free(&main);
+
+  MemSeg chained;
+  memseg_initChained(&chained, 64, KB(1));
+
+  char *first = (char*)memseg_alloc(&chained, 48);
+  memcpy(first, "first block", 12);
+  for (int i=0; i<16; i++) {
+    void *blk = memseg_alloc(&chained, 100);
+    printf("chained[%d] = %p (block max:%zu)\n", i, blk, chained.max);
+  }
+  printf("first: %s\n", first);
+
+  memseg_alloc(&chained, 3);
+  double *d = memseg_push(&chained, double);
+  uint64_t *zeroed = memseg_pushArrayZero(&chained, uint64_t, 4);
+  printf("double aligned: %d, zeroed[3] = %llu\n",
+    ((uint64_t)d % _Alignof(double)) == 0, (unsigned long long)zeroed[3]);
+
+  MemSeg_Mark mark = memseg_mark(&chained);
+  for (int i=0; i<64; i++) memseg_alloc(&chained, 100);
+  memseg_rewind(&chained, mark);
+  printf("rewound: loc=%zu same block=%d\n", chained.loc, chained.prev == mark.prev);
+
+  memseg_free(&chained);
+
+  MemSeg_Temp outer = memseg_getScratch(NULL, 0);
+  char *result = (char*)memseg_alloc(outer.memseg, 16);
+  snprintf(result, 16, "outer result");
+  MemSeg_Temp inner = memseg_getScratch(&outer.memseg, 1);
+  printf("scratch aliasing: %d\n", inner.memseg == outer.memseg);
+  memseg_alloc(inner.memseg, KB(256));
+  MemSeg *both[] = {outer.memseg, inner.memseg};
+  MemSeg_Temp none = memseg_getScratch(both, 2);
+  printf("scratch with every one in conflicts: %p\n", (void*)none.memseg);
+  memseg_releaseScratch(none);
+  memseg_releaseScratch(inner);
+  printf("survives inner scratch: %s\n", result);
+  memseg_releaseScratch(outer);
+  memseg_freeScratch();
+
+  MemSeg virt;
+  if (memseg_initVirtual(&virt, GB(1), MEMSEG_DECOMMIT) == 0) {
+    char *big = (char*)memseg_alloc(&virt, MB(20));
+    memset(big, 0xAB, MB(20));
+    printf("virtual: reserved=%zu committed=%zu\n", virt.cap, virt.max);
+    memseg_reset(&virt);
+    printf("virtual reset: committed=%zu\n", virt.max);
+    memseg_free(&virt);
+  }
 }
\ No newline at end of file
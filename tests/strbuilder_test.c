@@ -0,0 +1,95 @@
+#define STRVIEW_IMPLEMENTATION
+#define MEMSEG_IMPLEMENTATION
+#define STRBUILDER_IMPLEMENTATION
+#include "../strbuilder.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#define RESPONSES 1000000
+
+const char *status_text[] = {[200] = "OK", [404] = "Not Found"};
+
+int main() {
+  // every append lands in the same memseg block, growing in place
+  MemSeg memseg;
+  memseg_initChained(&memseg, KB(4), 0);
+  StrBuilder sb;
+  strbuilder_initMemSeg(&sb, &memseg, 16);
+  char *first = sb.data;
+  strbuilder_appendCStr(&sb, "values:");
+  for (int64_t i=-3; i<=3; i++) {
+    strbuilder_appendChar(&sb, ' ');
+    strbuilder_appendI64(&sb, i * 1000000007);
+  }
+  strbuilder_appendf(&sb, " %.2f %s", 3.14159, "pi");
+  strbuilder_append(&sb, strview_fromParts(" and more bytes than the first capacity", 39));
+  StrView view = strbuilder_view(&sb);
+  printf("%.*s\n(size=%zu capacity=%zu moved=%d)\n", (int)view.size, view.data, view.size, sb.capacity, sb.data != first);
+
+  // a fixed buffer truncates and reports it
+  char small[12];
+  strbuilder_initBuffer(&sb, small, sizeof(small));
+  bool ok = strbuilder_appendCStr(&sb, "0123456789ABCDEF");
+  ok = strbuilder_appendU64(&sb, 42) && ok;
+  printf("fixed: %s ok=%d overflow=%d\n", small, ok, sb.overflow);
+
+  // itoa against printf over the whole range
+  char expected[32];
+  int wrong = 0;
+  strbuilder_init(&sb, 0);
+  uint64_t seed = 88172645463325252ull;
+  for (int i=0; i<200000; i++) {
+    seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+    int64_t value = (int64_t)(seed >> (seed % 64));
+    if (i & 1) value = -value;
+    strbuilder_reset(&sb);
+    strbuilder_appendI64(&sb, value);
+    snprintf(expected, sizeof(expected), "%" PRId64, value);
+    if (strcmp(sb.data, expected) != 0) wrong++;
+  }
+  strbuilder_reset(&sb);
+  strbuilder_appendI64(&sb, INT64_MIN);
+  printf("itoa: %d wrong, min=%s\n", wrong, sb.data);
+  strbuilder_free(&sb);
+
+  // the HTTP status line, malloc + snprintf per response against a builder on the stack
+  char *version = "HTTP/1.1";
+  size_t total = 0;
+  clock_t start = clock();
+  for (int i=0; i<RESPONSES; i++) {
+    int code = i & 1 ? 200 : 404;
+    char *response = (char*)malloc(2048);
+    memset(response, 0, 2048);
+    snprintf(response, 2048, "%s %d %s\r\nContent-Length: %d\r\n\r\n", version, code, status_text[code], i);
+    total += strlen(response);
+    free(response);
+  }
+  double old = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  size_t built = 0;
+  char buffer[2048];
+  start = clock();
+  for (int i=0; i<RESPONSES; i++) {
+    int code = i & 1 ? 200 : 404;
+    strbuilder_initBuffer(&sb, buffer, sizeof(buffer));
+    strbuilder_appendCStr(&sb, version);
+    strbuilder_appendChar(&sb, ' ');
+    strbuilder_appendU64(&sb, code);
+    strbuilder_appendChar(&sb, ' ');
+    strbuilder_appendCStr(&sb, status_text[code]);
+    strbuilder_appendCStr(&sb, "\r\nContent-Length: ");
+    strbuilder_appendU64(&sb, i);
+    strbuilder_appendCStr(&sb, "\r\n\r\n");
+    built += strbuilder_view(&sb).size;
+  }
+  double builder = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("%d responses (%s): malloc + snprintf %.1f ms, strbuilder %.1f ms\n",
+    RESPONSES, total == built ? "ok" : "MISMATCH", old * 1e3, builder * 1e3);
+
+  memseg_free(&memseg);
+  return 0;
+}
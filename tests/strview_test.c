@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <time.h>
 
 #define STRVIEW_IMPLEMENTATION
 #include "../strview.h"
@@ -34,5 +35,86 @@ int main() {
   fputc(strview_getc(xyz), stdout);
   printf("%llu\n", strview_toU64(xyz));
 
+  StrView row = strview_fromCStr("id,name,,\"quoted\"\r\n");
+  printf("comma=%zu quote/eol=%zu name=%zu\n", strview_findChar(row, ','),
+    strview_findAny(row, strview_fromCStr("\"\r\n")), strview_findStr(row, strview_fromCStr("name")));
+
+  StrView field;
+  StrViewSplit split = strview_split(strview_chopByDelim(row, '\r'), ',');
+  while (strview_splitNext(&split, &field)) printf("[%.*s]", (int)field.size, field.data);
+  printf("\n");
+
+  // 16MB of short comma separated fields, byte loop against the vectorized split
+  size_t size = 16 << 20, fields = 0, expected = 0;
+  char *big = (char*)malloc(size);
+  for (size_t i=0; i<size; i++) big[i] = i % 11 == 10 ? ',' : 'a' + i % 26;
+
+  clock_t start = clock();
+  for (size_t begin = 0, i = 0; i <= size; i++) {
+    if (i == size || big[i] == ',') {
+      expected += i - begin;
+      begin = i + 1;
+    }
+  }
+  double bytewise = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  size_t total = 0;
+  start = clock();
+  split = strview_split(strview_fromParts(big, size), ',');
+  while (strview_splitNext(&split, &field)) {
+    total += field.size;
+    fields++;
+  }
+  double vectorized = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("split %zu fields (%s): byte loop %.1f ms, strview_split %.1f ms\n",
+    fields, total == expected ? "ok" : "MISMATCH", bytewise * 1e3, vectorized * 1e3);
+  free(big);
+
+  uint64_t u64;
+  int64_t i64;
+  double real;
+  size_t used;
+  int err = strview_parseU64(strview_fromCStr("18446744073709551615 rest"), &u64, &used);
+  printf("u64: %llu used=%zu err=%d\n", (unsigned long long)u64, used, err);
+  err = strview_parseU64(strview_fromCStr("18446744073709551616"), &u64, &used);
+  printf("u64 overflow: err=%d\n", err);
+  err = strview_parseI64(strview_fromCStr("-9223372036854775808"), &i64, &used);
+  printf("i64: %lld err=%d\n", (long long)i64, err);
+  err = strview_parseHex(strview_fromCStr("0xDeadBeefCafe1234,"), &u64, &used);
+  printf("hex: %llx used=%zu err=%d\n", (unsigned long long)u64, used, err);
+  err = strview_parseDouble(strview_fromCStr("-12.375e2x"), &real, &used);
+  printf("double: %g used=%zu err=%d\n", real, used, err);
+  err = strview_parseDouble(strview_fromCStr("-0e30"), &real, &used);
+  printf("negative zero: %g (strtod %g) used=%zu err=%d\n", real, strtod("-0e30", NULL), used, err);
+  err = strview_parseDouble(strview_fromCStr("abc"), &real, &used);
+  printf("empty: used=%zu err=%d\n", used, err);
+
+  // a million numbers of 1 to 19 digits (below INT64_MAX for atoll), the old malloc + atoll round trip against parseU64
+  size_t count = 1000000;
+  char (*numbers)[24] = malloc(sizeof(*numbers) * count);
+  uint64_t seed = 88172645463325252ull, sum = 0, check = 0;
+  for (size_t i=0; i<count; i++) {
+    seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+    snprintf(numbers[i], sizeof(numbers[i]), "%llu", (unsigned long long)(seed % 9000000000000000000ull >> (seed % 60)));
+  }
+
+  start = clock();
+  for (size_t i=0; i<count; i++) {
+    char *copy = strview_toCStr(strview_fromCStr(numbers[i]));
+    sum += atoll(copy);
+    free(copy);
+  }
+  double old = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  start = clock();
+  for (size_t i=0; i<count; i++) {
+    strview_parseU64(strview_fromCStr(numbers[i]), &u64, NULL);
+    check += u64;
+  }
+  double parsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("parse %zu numbers (%s): toCStr + atoll %.1f ms, strview_parseU64 %.1f ms\n",
+    count, sum == check ? "ok" : "MISMATCH", old * 1e3, parsed * 1e3);
+  free(numbers);
+
   return 0;
 }
\ No newline at end of file
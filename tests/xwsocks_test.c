@@ -1,5 +1,9 @@
 #define XWSOCKS_IMPLEMENTATION
 #include "../xwsocks.h"
+#define STRVIEW_IMPLEMENTATION
+#define MEMSEG_IMPLEMENTATION
+#define STRBUILDER_IMPLEMENTATION
+#include "../strbuilder.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,7 +12,7 @@
 
 #define PORT 8080
 
-char *make_http_response(char *http_version, int status_code);
+StrView make_http_response(StrBuilder *sb, char *http_version, int status_code);
 
 int main() {
   if (xwSocks_init() < 0) {
@@ -43,6 +47,7 @@ int main() {
   }
 
   char buffer[4096];
+  char response_buffer[2048];
   int running = 1;
 
   while (running) {
@@ -70,12 +75,14 @@ int main() {
     char *route = strtok(NULL, " ");
     char *version = strtok(NULL, " ");
 
-    char *response = make_http_response(version, 200);
-    if (xwSocks_send(client_socket, response, strlen(response), 0) < 0) {
+    // the response is built in place, nothing is allocated per request
+    StrBuilder sb;
+    strbuilder_initBuffer(&sb, response_buffer, sizeof(response_buffer));
+    StrView response = make_http_response(&sb, version, 200);
+    if (xwSocks_send(client_socket, (char*)response.data, response.size, 0) < 0) {
       fprintf(stderr, "Error sending\n");
 
       free(request);
-      free(response);
 
       if (xwSocks_close(client_socket) < 0)
         fprintf(stderr, "Error closing client socket\n");
@@ -84,7 +91,6 @@ int main() {
     }
 
     free(request);
-    free(response);
 
     if (xwSocks_close(client_socket) < 0) {
       fprintf(stderr, "Error closing client socket\n");
@@ -104,16 +110,13 @@ const char* status_codes_text[] = {
 	[200] = "OK",
 };
 
-char *make_http_response(char *http_version, int status_code) {
-  char* response = (char*)malloc(2048);
-	memset(response, 0, 2048);
+StrView make_http_response(StrBuilder *sb, char *http_version, int status_code) {
+	strbuilder_appendCStr(sb, http_version != NULL ? http_version : "HTTP/1.0");
+	strbuilder_appendChar(sb, ' ');
+	strbuilder_appendI64(sb, status_code);
+	strbuilder_appendChar(sb, ' ');
+	strbuilder_appendCStr(sb, status_codes_text[status_code]);
+	strbuilder_appendCStr(sb, "\r\n");
 
-	snprintf(response, 2048,
-		"%s %d %s\r\n",
-		http_version,
-		status_code,
-		status_codes_text[status_code]
-	);
-
-	return response;
+	return strbuilder_view(sb);
 }
\ No newline at end of file